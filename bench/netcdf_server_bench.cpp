@@ -0,0 +1,183 @@
+/*!
+    Microbenchmarks for the request path: parameter validation, slice extraction, 
+    JSON serialization, rendering and PNG encoding, against the sample file and a synthetic file 
+    generated at build time. Run from the project root ( generateVisual writes to assets/ ),
+    e.g. via the run_bench target, which writes the results as JSON.
+*/
+
+#include "netcdf_server.h"
+
+#include <benchmark/benchmark.h>
+
+// reaches into NetCDFServer's private stages, see the friend declaration in netcdf_server.h
+class NetCDFServerBench
+{
+    public:
+        static NetCDFServer& server( int dataset )
+        {
+            static NetCDFServer sample( BENCH_SAMPLE_FILE );
+            static NetCDFServer synthetic( BENCH_SYNTHETIC_FILE );
+            return dataset == 0 ? sample : synthetic;
+        }
+
+        static JSONValue extract( NetCDFServer& server, uint timeIndex, uint zIndex )
+        {
+            return server.extractNetCDFSlice( timeIndex, zIndex );
+        }
+
+        static bool validate( NetCDFServer& server, const Request& request )
+        {
+            JSONValue   result;
+            uint        timeIndex;
+            uint        zIndex;
+            return server.validateRequestParameters( request, result, timeIndex, zIndex );
+        }
+
+        static Response serialize( NetCDFServer& server, JSONValue& json )
+        {
+            return server.JSONResponse( json, APPLICATION_JSON );
+        }
+
+        static JSONList grid( NetCDFServer& server, const std :: vector<double>& values, size_t rows, size_t cols )
+        {
+            return server.to2DJSON( values, rows, cols );
+        }
+
+        // a real slice through the native renderer, viridis on the level's range
+        static std :: vector<uint8_t> colored( NetCDFServer& server, const Colormap& colormap, size_t& width, size_t& height )
+        {
+            auto            slice   =   server.readSlice( 1, 0 );
+            auto            range   =   server.dataset()->summaryIndex.range( 0 );
+            ColorScaling    scaling;
+
+            scaling.lo  =   range.first;
+            scaling.hi  =   range.second > range.first ? range.second : range.first + 1.0;
+            width       =   server.xCoords_.size();
+            height      =   server.yCoords_.size();
+            return server.renderRGBA( slice->data(), height, width, colormap, scaling );
+        }
+
+        static JSONValue render( NetCDFServer& server, const std :: vector<std :: vector<double>>& grid )
+        {
+            std :: string path = server.generateUniqueFileName( ASSETS_PATH, PNG_EXT );
+            JSONValue result = server.generateVisual( grid, path, { 0.0, 1e-3 } );
+
+            server.waitForFile( path, 2000, 10 );
+            std :: filesystem :: remove( path );
+            return result;
+        }
+};
+
+// Arg: 0 = sample file, 1 = synthetic file
+static void BM_ExtractNetCDFSlice( benchmark :: State& state )
+{
+    auto& server = NetCDFServerBench :: server( state.range( 0 ) );
+
+    for( auto _ : state )
+    {
+        JSONValue slice = NetCDFServerBench :: extract( server, 1, 0 );
+        benchmark :: DoNotOptimize( slice );
+    }
+}
+BENCHMARK( BM_ExtractNetCDFSlice )->Arg( 0 )->Arg( 1 )->Unit( benchmark :: kMicrosecond );
+
+// Arg: side of a square grid, building the JSON rows and dumping the response body
+static void BM_SerializeGrid( benchmark :: State& state )
+{
+    auto&   server  =   NetCDFServerBench :: server( 0 );
+    size_t  side    =   state.range( 0 );
+
+    std :: vector<double> values( side * side );
+    for( size_t i = 0; i < values.size(); i++ )
+        values[ i ] = 1e-6 * std :: sin( 0.001 * i );
+
+    for( auto _ : state )
+    {
+        JSONValue json;
+        json[ kConcentration ] = NetCDFServerBench :: grid( server, values, side, side );
+
+        Response response = NetCDFServerBench :: serialize( server, json );
+        benchmark :: DoNotOptimize( response.body );
+    }
+
+    state.SetItemsProcessed( state.iterations() * values.size() );
+}
+BENCHMARK( BM_SerializeGrid )->RangeMultiplier( 4 )->Range( 32, 1024 )->Unit( benchmark :: kMillisecond );
+
+static void BM_ValidateRequestParameters( benchmark :: State& state )
+{
+    auto&   server  =   NetCDFServerBench :: server( 0 );
+    Request request;
+    request.url_params = crow :: query_string( "/get-data?time=1&z=0" );
+
+    for( auto _ : state )
+        benchmark :: DoNotOptimize( NetCDFServerBench :: validate( server, request ) );
+}
+BENCHMARK( BM_ValidateRequestParameters );
+
+// needs gnuplot on the PATH
+static void BM_GenerateVisual( benchmark :: State& state )
+{
+    auto&   server  =   NetCDFServerBench :: server( 0 );
+    size_t  side    =   state.range( 0 );
+
+    std :: vector<std :: vector<double>> grid( side, std :: vector<double>( side ) );
+    for( size_t i = 0; i < side; i++ )
+        for( size_t j = 0; j < side; j++ )
+            grid[ i ][ j ] = 1e-3 * std :: exp( -1e-3 * ( ( i - side / 2.0 ) * ( i - side / 2.0 ) + ( j - side / 2.0 ) * ( j - side / 2.0 ) ) );
+
+    for( auto _ : state )
+    {
+        JSONValue result = NetCDFServerBench :: render( server, grid );
+        if( result.count( kError ) > 0 )
+        {
+            state.SkipWithError( "generateVisual failed" );
+            break;
+        }
+    }
+}
+BENCHMARK( BM_GenerateVisual )->Arg( 36 )->Arg( 256 )->Unit( benchmark :: kMillisecond )->UseRealTime();
+
+/*!
+    Args: dataset, 0 = RGBA / 1 = palette, PNGFilter, PNGStrategy, zlib level. Reports the 
+    encoded size as the bytes counter, to weigh encode time against bandwidth.
+*/
+static void BM_EncodePNG( benchmark :: State& state )
+{
+    auto&           server      =   NetCDFServerBench :: server( state.range( 0 ) );
+    const Colormap& colormap    =   *Colormap :: find( "viridis" );
+    bool            palette     =   state.range( 1 ) == 1;
+    size_t          width;
+    size_t          height;
+    PNGOptions      options;
+
+    options.filter      =   static_cast<PNGFilter>( state.range( 2 ) );
+    options.strategy    =   static_cast<PNGStrategy>( state.range( 3 ) );
+    options.level       =   state.range( 4 );
+
+    auto                    rgba    =   NetCDFServerBench :: colored( server, colormap, width, height );
+    std :: vector<uint8_t>  indices( width * height );
+    colormap.toPaletteIndices( rgba.data(), indices.size(), indices.data() );
+
+    size_t bytes = 0;
+    for( auto _ : state )
+    {
+        std :: string png = palette ? encodeIndexedPNG( indices.data(), width, height, colormap.palette(), options ) 
+                                    : encodePNG( rgba.data(), width, height, options );
+        bytes = png.size();
+        benchmark :: DoNotOptimize( png );
+    }
+
+    state.counters[ "bytes" ] = bytes;
+    state.SetItemsProcessed( state.iterations() * width * height );
+}
+BENCHMARK( BM_EncodePNG )
+    ->ArgNames( { "dataset", "palette", "filter", "strategy", "level" } )
+    ->ArgsProduct( { { 0, 1 }, 
+                     { 0, 1 }, 
+                     { int( PNGFilter :: NONE ), int( PNGFilter :: SUB ), int( PNGFilter :: PAETH ), int( PNGFilter :: ADAPTIVE ) }, 
+                     { int( PNGStrategy :: DEFAULT ), int( PNGStrategy :: RLE ) }, 
+                     { 1, 6, 9 } } )
+    ->Unit( benchmark :: kMillisecond );
+
+BENCHMARK_MAIN();
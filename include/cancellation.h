@@ -0,0 +1,112 @@
+#ifndef CANCELLATION_H
+#define CANCELLATION_H
+
+#include <atomic>
+#include <chrono>
+
+/*!
+    Thrown by CancelToken :: check(). Deliberately not a std :: exception, so the
+    catch( const std :: exception& ) blocks that turn read and render failures into
+    500s let it through to the code that started the request.
+*/
+struct RequestCancelled
+{
+    enum Reason
+    {
+        DEADLINE,
+        DISCONNECTED
+    };
+
+    Reason  reason;
+};
+
+/*!
+    Whether the work for one request should go on: false once its deadline has passed
+    or its client is gone. Long running code calls check() between phases and inside 
+    loops, which throws RequestCancelled so the work unwinds instead of finishing for 
+    nobody. The token a thread works under is set with Scope and read with current(), 
+    parallelFor hands it on to its workers. Connection state is only known on the 
+    connection's IO thread, which reports a lost client with disconnect(); workers 
+    only ever read the flag.
+*/
+class CancelToken
+{
+    public:
+        using Clock = std :: chrono :: steady_clock;
+
+        explicit CancelToken( Clock :: time_point deadline ) : deadline_( deadline )
+        {
+        }
+
+        CancelToken( const CancelToken& ) = delete;
+        CancelToken& operator=( const CancelToken& ) = delete;
+
+        // the client went away, safe from any thread
+        void    disconnect  ()
+        {
+            connected_.store( false, std :: memory_order_relaxed );
+        }
+
+        bool    cancelled   ( RequestCancelled :: Reason& reason ) const
+        {
+            if( Clock :: now() >= deadline_ )
+            {
+                reason = RequestCancelled :: DEADLINE;
+                return true;
+            }
+            if( !connected_.load( std :: memory_order_relaxed ) )
+            {
+                reason = RequestCancelled :: DISCONNECTED;
+                return true;
+            }
+            return false;
+        }
+
+        void    check       () const
+        {
+            RequestCancelled :: Reason reason;
+            if( cancelled( reason ) )
+                throw RequestCancelled{ reason };
+        }
+
+        Clock :: time_point     deadline() const { return deadline_; }
+
+        // the calling thread's token, nullptr outside a request
+        static const CancelToken*   current () { return current_; }
+
+        // check() on the calling thread's token, if any
+        static void     checkCurrent()
+        {
+            if( current_ )
+                current_->check();
+        }
+
+        // makes token the calling thread's for the enclosing scope
+        class Scope
+        {
+            public:
+                explicit Scope( const CancelToken* token ) : previous_( current_ )
+                {
+                    current_ = token;
+                }
+
+                ~Scope()
+                {
+                    current_ = previous_;
+                }
+
+                Scope( const Scope& ) = delete;
+                Scope& operator=( const Scope& ) = delete;
+
+            private:
+                const CancelToken*  previous_;
+        };
+
+    private:
+        Clock :: time_point         deadline_;
+        std :: atomic<bool>         connected_{ true };
+
+        static inline thread_local const CancelToken*   current_    =   nullptr;
+};
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef COLORMAP_H
+#define COLORMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class ColorScale
+{
+    LINEAR,
+    LOG10,
+    BREAKS
+};
+
+/*!
+    How values are placed on a colormap. LINEAR and LOG10 spread [ lo, hi ] over the
+    whole table ( LOG10 needs 0 < lo ), values outside are clamped to the end colors.
+    BREAKS uses the ascending thresholds in breaks: a value in [ breaks[ k ], breaks[ k + 1 ] )
+    gets the k-th of breaks.size() colors spread evenly over the table.
+*/
+struct ColorScaling
+{
+    ColorScale              scale   =   ColorScale :: LINEAR;
+    double                  lo      =   0.0;
+    double                  hi      =   1.0;
+    std :: vector<double>   breaks;
+};
+
+/*!
+    Named colormap baked into a lookup table of RGBA entries ( 256 or 4096 ), plus one
+    transparent entry past the end for NaN, non-positive values under LOG10 and values
+    below the first break. Smooth maps interpolate their stops, stepped ( hazard ) maps
+    repeat each stop over an equal share of the table. Tables are built once per process.
+*/
+class Colormap
+{
+    public:
+        static constexpr size_t SMALL_LUT   =   256;
+        static constexpr size_t LARGE_LUT   =   4096;
+
+        // nullptr for an unknown name or table size
+        static const Colormap*                  find    ( const std :: string& name, size_t lutSize = SMALL_LUT );
+        static const std :: vector<std :: string>&  names   ();
+
+        /*!
+            values -> 4 bytes each of R, G, B, A. Uses AVX2 ( 4 values, gathered from the
+            table ) or NEON ( 2 values ) for LINEAR and LOG10 when built with them, and the
+            same arithmetic in scalar code otherwise, so every path picks the same entries.
+        */
+        void        toRGBA  ( const double* values, size_t size, const ColorScaling& scaling, uint8_t* rgba ) const;
+
+        size_t      size    () const { return lut_.size() - 1; }
+        bool        stepped () const { return stepped_; }
+
+        // entry i as R | G << 8 | B << 16 | A << 24, i == size() is the transparent one
+        uint32_t    entry   ( size_t i ) const { return lut_[ i ]; }
+
+        /*!
+            The table as an indexed image palette of PALETTE_SIZE entries: 0 is transparent, 
+            1..255 sample the table evenly ( so a 256 entry table merges one adjacent pair ). 
+            toPaletteIndices maps toRGBA output onto it.
+        */
+        static constexpr size_t PALETTE_SIZE    =   256;
+
+        const std :: vector<uint32_t>&  palette ()  const { return palette_; }
+        void        toPaletteIndices( const uint8_t* rgba, size_t size, uint8_t* indices ) const;
+
+        // one stop, 0xRRGGBB
+        using Stops = std :: vector<uint32_t>;
+
+    private:
+        Colormap( const Stops& stops, bool stepped, size_t lutSize );
+
+        std :: vector<uint32_t>                     lut_;
+        bool                                        stepped_;
+        std :: vector<uint32_t>                     palette_;
+        std :: unordered_map<uint32_t, uint8_t>     paletteIndex_;
+};
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef COMPUTE_POOL_H
+#define COMPUTE_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*!
+    Fixed set of worker threads for request work, kept apart from the IO threads so a 
+    slow read or render never stalls the connections sharing an IO thread. 
+
+    Tasks are submitted to one of a few priority classes, 0 being the most urgent. Each 
+    class has its own FIFO queue, a bound on how many of its tasks may wait and a bound 
+    on how many of its tasks and those of every less urgent class may run at once. A 
+    free worker takes the oldest task of the most urgent class that is under its 
+    concurrency bound, so cheap work overtakes a backlog of expensive work, and a class 
+    bounded below the worker count always leaves the more urgent ones a free worker. 
+    Helpers a running task hands out for its own work ( see parallelFor ) wait in a 
+    separate lane of its class, ahead of its queued tasks and holding up to one per 
+    worker, so they never take the room that admits new work; they still count against 
+    the concurrency bounds. 
+    A task that throws is dropped without taking its worker down; tasks are expected to 
+    report their own failures.
+*/
+class ComputePool
+{
+    public:
+        using Task = std :: function<void()>;
+
+        struct Class
+        {
+            size_t  capacity;           // tasks allowed to wait, trySubmit refuses beyond it
+            size_t  concurrency;        // tasks of this and less urgent classes allowed to run at once, 0 = every worker
+        };
+
+        // threads = 0 uses one per hardware thread
+        ComputePool( size_t threads, const std :: vector<Class>& classes );
+
+        // queued tasks are dropped, running ones finish
+        ~ComputePool();
+
+        ComputePool( const ComputePool& ) = delete;
+        ComputePool& operator=( const ComputePool& ) = delete;
+
+        // false, without running task, when the class already has capacity tasks waiting
+        bool    trySubmit   ( size_t priority, Task task );
+
+        // a helper for a task already running in the class; false when the helper lane is full
+        bool    trySubmitHelper( size_t priority, Task task );
+
+        size_t  queued      ( size_t priority ) const;
+        size_t  running     ( size_t priority ) const;
+        size_t  threads     () const { return threads_.size(); }
+
+        // the pool and class of the task the calling thread runs, nullptr / 0 off the pool
+        static ComputePool*     current         () { return current_; }
+        static size_t           currentPriority () { return currentPriority_; }
+
+    private:
+        struct Queue
+        {
+            Class               limits;
+            std :: deque<Task>  tasks;
+            std :: deque<Task>  helpers;
+            size_t              running     =   0;
+        };
+
+        // under mutex_, the most urgent queue with a task it may start, nullptr if none
+        Queue*  next        ();
+        void    work        ();
+
+        std :: vector<Queue>                        queues_;
+        std :: vector<std :: thread>                threads_;
+
+        mutable std :: mutex                        mutex_;
+        std :: condition_variable                   wake_;
+        bool                                        stop_       =   false;
+
+        static inline thread_local ComputePool*     current_            =   nullptr;
+        static inline thread_local size_t           currentPriority_    =   0;
+};
+
+#endif
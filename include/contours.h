@@ -0,0 +1,25 @@
+#ifndef CONTOURS_H
+#define CONTOURS_H
+
+#include <array>
+#include <vector>
+
+// ( x, y ) in coordinate units; rings are closed, the first point is repeated at the end
+using Point     =   std :: array<double, 2>;
+using Ring      =   std :: vector<Point>;
+
+// exterior ring ( counter-clockwise ) followed by its holes ( clockwise ), as in GeoJSON
+using Polygon   =   std :: vector<Ring>;
+
+/*!
+    Marching squares over a row-major ( y, x ) plane, in the physical coordinates given
+    by the x and y axes. Returns the regions where values >= level as polygons with holes.
+    The plane is treated as bordered by "below level" cells, so every boundary closes 
+    into a ring and regions touching the grid edge are clipped to it. NaN counts as below.
+*/
+std :: vector<Polygon> contourPolygons( const double* values, 
+                                        const std :: vector<double>& x, 
+                                        const std :: vector<double>& y, 
+                                        double level );
+
+#endif
@@ -247,7 +247,12 @@ namespace crow
                 }
                 if (complete_request_handler_)
                 {
-                    complete_request_handler_();
+                    // The handler owns the connection (and so this response) and the connection
+                    // clears it while completing. When end() is called after the handler returned,
+                    // from another thread, it can be the last owner, so keep it until we are done.
+                    std::function<void()> complete_request_handler;
+                    complete_request_handler.swap(complete_request_handler_);
+                    complete_request_handler();
                     manual_length_header = false;
                     skip_body = false;
                 }
@@ -0,0 +1,22 @@
+#ifndef GIF_ENCODER_H
+#define GIF_ENCODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*!
+    Animated GIF89a, looping forever, from 8 bit palette index frames ( top row first ).
+    palette holds up to 256 colors as R | G << 8 | B << 16, higher bits ignored; transparent,
+    when in range, is the index drawn as transparent. Each frame replaces the previous one.
+    delay is in hundredths of a second, as GIF stores it.
+*/
+std :: string   encodeGIF( const std :: vector<const uint8_t*>& frames,
+                           uint16_t width,
+                           uint16_t height,
+                           const std :: vector<uint32_t>& palette,
+                           int transparent,
+                           uint16_t delayCs );
+
+#endif
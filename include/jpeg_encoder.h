@@ -0,0 +1,19 @@
+#ifndef JPEG_ENCODER_H
+#define JPEG_ENCODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*!
+    8 bit RGBA rows ( top row first, width * 4 bytes each ) to a baseline JPEG file. 
+    JPEG has no alpha, so pixels are blended over background ( 0xRRGGBB ), one row at a time.
+    quality is libjpeg's, 1 - 100.
+*/
+std :: string   encodeJPEG( const uint8_t* rgba, 
+                            uint32_t width, 
+                            uint32_t height, 
+                            int quality, 
+                            uint32_t background = 0xffffff );
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*!
+    Process wide request metrics, scraped in Prometheus text format.
+    Every thread that records gets its own shard of plain relaxed atomics, written 
+    only by that thread, so the hot path is a few uncontended stores; the scrape 
+    sums the shards. Latencies go into log-linear ( HDR style ) histograms per 
+    route and phase. Routes are registered once at startup and referred to by id.
+*/
+class Metrics
+{
+    public:
+        enum Phase
+        {
+            VALIDATE,
+            READ,
+            TRANSFORM,
+            JSON_BUILD,
+            SERIALIZE,
+            RENDER,
+            ENCODE,
+            QUEUE,
+            TOTAL,
+            PHASE_COUNT
+        };
+
+        static constexpr size_t MAX_ROUTES  =   32;
+
+        // not thread safe against recording, call before serving
+        static size_t           registerRoute   ( const std :: string& route );
+
+        // route the calling thread's subsequent phases are attributed to
+        static void             beginRequest    ( size_t route );
+        static void             recordPhase     ( Phase phase, uint64_t micros );
+        static void             endRequest      ( int statusCode, uint64_t micros );
+
+        // route the calling thread is attributing to, MAX_ROUTES outside a request
+        static size_t           requestRoute    ();
+
+        /*!
+            Attributes the calling thread's phases to route for the enclosing scope, so 
+            work a request hands to other threads lands in its route's histograms. Only 
+            the request's own thread feeds its Server-Timing.
+        */
+        class RouteScope
+        {
+            public:
+                explicit RouteScope( size_t route );
+                ~RouteScope();
+
+                RouteScope( const RouteScope& ) = delete;
+                RouteScope& operator=( const RouteScope& ) = delete;
+
+            private:
+                size_t  previous_;
+        };
+
+        // the current request reused another request's in-flight result
+        static void             recordCoalesced ();
+
+        // the current request was turned away because the compute queue was full
+        static void             recordShed      ();
+
+        // the current request was abandoned past its deadline or after its client left
+        static void             recordCancelled ();
+
+        // Server-Timing header value for the calling thread's current ( or just ended ) request
+        static std :: string    serverTiming    ();
+
+        static std :: string    prometheus      ();
+
+        static const char*      phaseName       ( Phase phase );
+};
+
+#endif
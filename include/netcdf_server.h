@@ -12,10 +12,34 @@
 #include "netcdf/ncGroupAtt.h"
 #include "netcdf/ncGroup.h"
 #include "matplot/matplot.h"
+#include "cancellation.h"
+#include "colormap.h"
+#include "compute_pool.h"
+#include "contours.h"
+#include "gif_encoder.h"
+#include "jpeg_encoder.h"
+#include "metrics.h"
+#include "phase_timer.h"
+#include "png_encoder.h"
+#include "rate_limit_middleware.h"
+#include "reductions.h"
+#include "resample.h"
+#include "result_cache.h"
+#include "single_flight.h"
+#include "slice_summary.h"
+#include "svg_writer.h"
+#include "webp_encoder.h"
 #include <string>
 #include <algorithm>
 #include <iostream>
 #include <shared_mutex>
+#include <functional>
+#include <future>
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <thread>
+#include <unordered_map>
 
 using JSONValue = crow :: json :: wvalue;
 using JSONMap   = crow :: json :: wvalue :: object;
@@ -29,13 +53,31 @@ using namespace matplot;
 
 // JSON and header strings
 const std :: string APPLICATION_JSON    =   "application/json";
+const std :: string APPLICATION_GEOJSON =   "application/geo+json";
 const std :: string IMAGE_PNG           =   "image/png";
+const std :: string IMAGE_APNG          =   "image/apng";
+const std :: string IMAGE_GIF           =   "image/gif";
+const std :: string IMAGE_JPEG          =   "image/jpeg";
+const std :: string IMAGE_WEBP          =   "image/webp";
+const std :: string IMAGE_SVG           =   "image/svg+xml";
+const std :: string TEXT_PROMETHEUS     =   "text/plain; version=0.0.4";
+const std :: string OCTET_STREAM        =   "application/octet-stream";
 const std :: string NO_CACHE_NO_STORE   =   "no-cache, no-store";
 
+// a response is fixed by the data file and the query, so successful ones can be cached;
+// slices never change, get-info is revalidated against its ETag
+const std :: string CACHE_IMMUTABLE     =   "public, max-age=31536000, immutable";
+const std :: string CACHE_REVALIDATE    =   "no-cache";
+
+// folded into every ETag, bump when a response format changes so cached bodies are not reused
+constexpr uint64_t ENTITY_VERSION       =   1;
+
 // repeated keys
 constexpr char kConcentration[]         =   "concentration";
 constexpr char kX[]                     =   "x";
 constexpr char kY[]                     =   "y";
+constexpr char kTime[]                  =   "time";
+constexpr char kZ[]                     =   "z";
 
 constexpr char kError[]                 =   "error";
 
@@ -43,6 +85,104 @@ constexpr char kError[]                 =   "error";
 const std :: string ASSETS_PATH         =   "assets/";
 const std :: string PNG_EXT             =   ".png";
 
+// multi-slice bodies are spooled here a slice at a time and sent from disk, each file is 
+// removed once sent and any left behind ( e.g. by a shutdown ) after SPOOL_MAX_AGE_S; 
+// a body that would take the spool past SPOOL_MAX_BYTES is refused with 503. Crow sends 
+// it with blocking writes on the connection's IO thread, stalling that thread's other 
+// connections for as long as a slow client takes, so one body is capped at SPOOL_MAX_BODY_BYTES
+const std :: string SPOOL_PATH          =   "assets/spool/";
+const std :: string JSON_EXT            =   ".json";
+const std :: string BIN_EXT             =   ".bin";
+constexpr int SPOOL_MAX_AGE_S           =   300;
+constexpr uint64_t SPOOL_MAX_BYTES      =   uint64_t( 2 ) << 30;
+constexpr uint64_t SPOOL_MAX_BODY_BYTES =   uint64_t( 256 ) << 20;
+
+// get-image parameters that select the native colormap renderer over the matplot++ figure
+const std :: vector<std :: string> IMAGE_PARAMETERS = { "colormap", "scale", "breaks", "vmin", "vmax", "lut", "width", "height", "resample" };
+
+// get-image output format for the native renderer, from format= or the Accept header, and the 
+// default lossy qualities; encoded images are cached per query and format. levels are contours 
+// drawn over format=svg
+const std :: vector<std :: string> IMAGE_FORMAT_PARAMETERS = { "format", "quality", "levels" };
+constexpr int JPEG_QUALITY              =   85;
+constexpr int WEBP_QUALITY              =   80;
+constexpr size_t IMAGE_CACHE_SIZE       =   64;
+
+// svg canvas units: default plot width, the margin around it and the colorbar beside it
+constexpr double SVG_PLOT_WIDTH         =   800.0;
+constexpr double SVG_MARGIN             =   10.0;
+constexpr double SVG_BAR_WIDTH          =   18.0;
+constexpr double SVG_LABEL_WIDTH        =   70.0;
+
+// largest native image side, in pixels
+constexpr size_t MAX_IMAGE_SIDE         =   8192;
+
+// native PNG encoding, chosen from BM_EncodePNG on concentration slices: filtering pays 
+// off on palette indices, RGBA rows deflate best unfiltered
+const PNGOptions PNG_PALETTE_OPTIONS    =   { 6, PNGStrategy :: DEFAULT, PNGFilter :: SUB };
+const PNGOptions PNG_RGBA_OPTIONS       =   { 6, PNGStrategy :: DEFAULT, PNGFilter :: NONE };
+
+// default log10 color scale spans this many decades below the level's maximum
+constexpr int LOG_DECADES               =   6;
+
+// get-animation limits: frames x width x height, and the number of encoded animations kept
+constexpr size_t MAX_ANIMATION_PIXELS   =   size_t( 1 ) << 25;
+constexpr size_t ANIMATION_CACHE_SIZE   =   32;
+constexpr size_t DEFAULT_FRAME_DELAY_MS =   200;
+
+// how often the data file is checked for appended time steps to push to subscribers
+constexpr int WATCH_INTERVAL_MS         =   1000;
+
+// values held in memory at once while reducing over time steps
+constexpr size_t STATS_BATCH_VALUES     =   size_t( 1 ) << 24;
+
+// memory budget for cached cumulative dose planes, and the minimum values per parallel task
+constexpr size_t DOSE_CACHE_BYTES       =   size_t( 512 ) << 20;
+constexpr size_t DOSE_TASK_VALUES       =   size_t( 1 ) << 16;
+
+// request work runs on a compute pool apart from the IO threads, queued by estimated cost; 
+// tasks waiting beyond a class's queue size are refused with 503 and a Retry-After of RETRY_AFTER_S seconds
+constexpr size_t CHEAP_QUEUE_SIZE       =   256;
+constexpr size_t MODERATE_QUEUE_SIZE    =   128;
+constexpr size_t EXPENSIVE_QUEUE_SIZE   =   64;
+constexpr int RETRY_AFTER_S             =   1;
+
+// cost is estimated in grid values read, renders weigh RENDER_COST_WEIGHT per value and output 
+// pixel; below CHEAP_COST a request is cheap, from EXPENSIVE_COST on it is expensive
+constexpr size_t CHEAP_COST             =   size_t( 1 ) << 18;
+constexpr size_t EXPENSIVE_COST         =   size_t( 1 ) << 22;
+constexpr size_t RENDER_COST_WEIGHT     =   4;
+
+// per route deadlines in ms, counted from arrival so queueing uses them up too; work still 
+// running past its deadline, or after crow closed its connection, is abandoned with a 504
+const std :: unordered_map<std :: string, uint> ROUTE_DEADLINES_MS = 
+{
+    { "/get-data",          15000 },
+    { "/get-image",         30000 },
+    { "/get-stats",         60000 },
+    { "/get-dose",          60000 },
+    { "/get-contours",      30000 },
+    { "/get-exceedance",    60000 },
+    { "/get-raw",           120000 },
+    { "/get-animation",     120000 }
+};
+
+// how often a pending response's connection is checked from its IO thread. Crow does not 
+// read the socket until the response is sent, so only connections crow closed itself 
+// ( e.g. on shutdown ) show up; a client that silently went away is bounded by the deadline
+constexpr uint LIVENESS_CHECK_MS        =   250;
+
+// per client ( API_KEY_HEADER, else the address ) request rate and burst, and how many 
+// requests that are not Cost :: CHEAP it may have in flight; over either limit gets 429
+constexpr double RATE_LIMIT_PER_S       =   50.0;
+constexpr double RATE_LIMIT_BURST       =   100.0;
+constexpr uint MAX_CLIENT_IN_FLIGHT     =   4;
+const std :: string API_KEY_HEADER      =   "X-API-Key";
+
+// load balancers / reverse proxies in front of the server, as crow sees their address; 
+// behind one the client address comes from its X-Forwarded-For, see setTrustedProxies
+const std :: vector<std :: string> TRUSTED_PROXIES = {};
+
 // Error strings
 namespace Errors 
 {
@@ -59,16 +199,108 @@ namespace Errors
     const std :: string EXTRACT_NCDF    =   "NetCDFServer :: extractNetCDFSlice: Failed to extract NetCDF data: ";
     const std :: string GRID_EMPTY      =   "NetCDFServer :: generateVisual: Grid data is empty. ";
     const std :: string PNG_TIMEOUT     =   "NetCDFServer :: handleGetImage: Timed out waiting for png visualization. ";
+    const std :: string FAIL_STATS      =   "NetCDFServer :: handleGetStats: Failed to compute statistics: ";
+    const std :: string TIME_END_ORDER  =   "NetCDFServer :: handleGetStats: time_end must not precede time. ";
+    const std :: string INVALID_BBOX    =   "NetCDFServer :: parseRegion: bbox must be xmin,ymin,xmax,ymax and overlap the grid. ";
+    const std :: string INVALID_PCTL    =   "NetCDFServer :: handleGetStats: percentiles must be comma separated values in [0, 100]. ";
+    const std :: string INVALID_LEVELS  =   "NetCDFServer :: handleGetContours: levels must be a comma separated list of numbers. ";
+    const std :: string INVALID_LEVEL   =   "NetCDFServer :: handleGetExceedance: level must be a single number. ";
+    const std :: string FAIL_DOSE       =   "NetCDFServer :: handleGetDose: Failed to integrate dose: ";
+    const std :: string FAIL_SPOOL      =   "NetCDFServer :: spooledResponse: Failed to write spool file: ";
+    const std :: string SPOOL_FULL      =   "NetCDFServer :: spooledResponse: Server busy, spool space is full. Retry later. ";
+    const std :: string SPOOL_BODY      =   "NetCDFServer :: spooledResponse: Response too large, ask for fewer time steps or a byte range. It cannot exceed ";
+    const std :: string INVALID_FORMAT  =   "NetCDFServer :: parseSubscription: format must be json or raw. ";
+    const std :: string UNKNOWN_DATASET =   "NetCDFServer :: parseSubscription: this server only serves ";
+    const std :: string FAIL_PUSH       =   "NetCDFServer :: publishNewTimeSteps: Failed to push new time steps: ";
+    const std :: string INVALID_CMAP    =   "NetCDFServer :: parseColorScaling: colormap must be one of ";
+    const std :: string INVALID_SCALE   =   "NetCDFServer :: parseColorScaling: scale must be linear, log or breaks. ";
+    const std :: string INVALID_BREAKS  =   "NetCDFServer :: parseColorScaling: scale=breaks needs breaks, an ascending comma separated list of numbers. ";
+    const std :: string INVALID_VRANGE  =   "NetCDFServer :: parseColorScaling: vmin and vmax must be single numbers with vmin < vmax ( and vmin > 0 for scale=log ). ";
+    const std :: string INVALID_LUT     =   "NetCDFServer :: parseColorScaling: lut must be 256 or 4096. ";
+    const std :: string INVALID_SIZE    =   "NetCDFServer :: parseImageSize: width and height must be whole numbers from 1 to 8192. ";
+    const std :: string INVALID_RESAMP  =   "NetCDFServer :: parseImageSize: resample must be nearest or bilinear. ";
+    const std :: string INVALID_IMGFMT  =   "NetCDFServer :: parseImageFormat: format must be png, jpeg, webp ( only when built with libwebp ) or svg. ";
+    const std :: string SVG_LEVELS      =   "NetCDFServer :: parseImageFormat: levels must be a comma separated list of numbers, with format=svg only. ";
+    const std :: string INVALID_QUALITY =   "NetCDFServer :: parseImageFormat: quality must be a whole number from 1 to 100. ";
+    const std :: string INVALID_FRAMES  =   "NetCDFServer :: handleGetAnimation: Missing or invalid parameters: z, from and to must be indices with from <= to. ";
+    const std :: string INVALID_ANIFMT  =   "NetCDFServer :: handleGetAnimation: format must be apng or gif. ";
+    const std :: string INVALID_DELAY   =   "NetCDFServer :: handleGetAnimation: delay must be whole milliseconds from 10 to 10000. ";
+    const std :: string ANIMATION_SIZE  =   "NetCDFServer :: handleGetAnimation: frames x width x height cannot exceed ";
+    const std :: string FAIL_ANIMATION  =   "NetCDFServer :: handleGetAnimation: Failed to render animation: ";
+    const std :: string FAIL_RAW        =   "NetCDFServer :: handleGetRaw: Failed to read concentration: ";
+    const std :: string OVERLOADED      =   "NetCDFServer :: offload: Server busy, compute queue is full. Retry later. ";
+    const std :: string FAIL_REQUEST    =   "NetCDFServer :: offload: Request failed: ";
+    const std :: string DEADLINE        =   "NetCDFServer :: offload: Request deadline exceeded, the work was abandoned. ";
+    const std :: string CLIENT_GONE     =   "NetCDFServer :: offload: Client disconnected, the work was abandoned. ";
 }
 
+// encodings of the native image renderer
+enum class ImageFormat
+{
+    PNG,
+    JPEG,
+    WEBP,
+    SVG
+};
+
+// compute pool priority classes, most urgent first. Expensive work may use half the 
+// workers and moderate and expensive work together three quarters ( at most all but 
+// one ), so cheap requests always find one free
+enum class Cost
+{
+    CHEAP,
+    MODERATE,
+    EXPENSIVE
+};
+
+// index window over the ( y, x ) plane
+struct Region
+{
+    size_t  y0  =   0;
+    size_t  ny  =   0;
+    size_t  x0  =   0;
+    size_t  nx  =   0;
+};
+
+// outcome of a Range header against a body of known size
+enum class ByteRange
+{
+    FULL,           // absent, malformed or multi-range, send everything
+    PARTIAL,        // one satisfiable range
+    UNSATISFIABLE
+};
+
 class NetCDFServer
 {
+    // benchmarks drive the private stages directly
+    friend class NetCDFServerBench;
+
     public:
         // ctor
         explicit    NetCDFServer( const std :: string& fileName );
+                    ~NetCDFServer();
+
+        /*!
+            crow server run method. threads are IO threads, they only parse requests and 
+            write responses, 0 uses a quarter of the hardware threads ( at least 2 ); request 
+            work runs on computeThreads pool workers, 0 uses one per hardware thread
+        */
+        void        run         ( uint port = 18080, uint threads = 0, uint computeThreads = 0 ); 
+
+        // non-blocking run for in-process harnesses, returns once listening; 
+        // the future completes after stop()
+        std :: future<void>     runAsync( uint port = 0, uint threads = 0, uint computeThreads = 0 );
+        uint16_t                port    () const;
+        void                    stop    ();
 
-        // crow server run method
-        void        run         ( uint port = 18080 ); 
+        // per client limits, see RateLimiter; call before run, perSecond = 0 and maxInFlight = 0 turn them off
+        void                    setRateLimit( double perSecond, double burst, uint maxInFlight );
+
+        // proxies whose X-Forwarded-For names the client for the rate limit; call before run
+        void                    setTrustedProxies( const std :: vector<std :: string>& addresses );
+
+        // deadline for a route ( e.g. "/get-image" ) in ms, 0 = none; call before run
+        void                    setDeadline ( const std :: string& route, uint deadlineMs );
 
         // getters and setters, would go here
         std :: string getFileName()
@@ -84,16 +316,108 @@ class NetCDFServer
 
         // png visualization mutex
         std :: mutex                png_mutex;
+
+        // the NetCDF library is not thread safe, every call on dataFile_ or another handle holds this
+        std :: mutex                ncMutex_;
+
+        // x and y coordinate variables, read once at startup
+        std :: vector<double>       xCoords_;
+        std :: vector<double>       yCoords_;
+
+        // concentration's fill value, read back as NaN
+        double                      fillValue_  =   NC_FILL_DOUBLE;
+
+        /*!
+            What appending time steps changes: the time coordinates, the per ( time, z ) 
+            min/max/mean/nonzero table and the tag identifying the file version ( size, 
+            mtime ) in ETags. Built at startup and again by publishNewTimeSteps, requests 
+            take the current one through dataset(). The file only grows, so an index 
+            checked against one version is valid in every later one.
+        */
+        struct DatasetVersion
+        {
+            std :: vector<double>   timeCoords;
+            SliceSummaryIndex       summaryIndex;
+            std :: string           tag;
+        };
+
+        std :: shared_ptr<const DatasetVersion>     dataset_;
+        mutable std :: mutex                        datasetMutex_;
+
+        // serialized get-stats bodies keyed by the response's ETag ( dataset version and canonical query )
+        ResultCache<std :: string, std :: string>   statsCache_;
+
+        // serialized get-contours GeoJSON keyed by the response's ETag
+        ResultCache<std :: string, std :: string>   contourCache_;
+
+        // encoded native get-image bodies keyed by the response's ETag, which varies with Accept
+        ResultCache<std :: string, std :: string>   imageCache_{ IMAGE_CACHE_SIZE };
+
+        // encoded get-animation files keyed by the response's ETag, shared by identical concurrent requests
+        ResultCache<std :: string, std :: string>   animationCache_{ ANIMATION_CACHE_SIZE };
+        SingleFlight<std :: string, std :: string>  animationFlight_;
+
+        // running dose planes keyed by sliceKey( time, z ), sized from DOSE_CACHE_BYTES once the grid is known
+        std :: unique_ptr<ResultCache<uint64_t, std :: vector<double>>>  doseCache_;
+
+        // identical concurrent get-dose requests integrate once, keyed the same way
+        SingleFlight<uint64_t, std :: vector<double>>   doseFlight_;
+
+        // a serialized get-data body and the status it goes out with
+        struct SliceBody
+        {
+            uint            code;
+            std :: string   body;
+        };
+
+        // identical concurrent get-data / get-image requests share one read, keyed by sliceKey( time, z )
+        SingleFlight<uint64_t, SliceBody>               dataFlight_;
+        SingleFlight<uint64_t, std :: vector<double>>   sliceFlight_;
     
+        // what a websocket subscriber gets pushed for every new time step
+        struct Subscription
+        {
+            size_t  zIndex  =   0;
+            Region  region;
+            bool    binary  =   false;
+        };
+
+        // parsed from the upgrade request in onaccept, second is the error when it was rejected
+        using PendingSubscription = std :: pair<Subscription, std :: string>;
+
+        std :: mutex                                                        subscribersMutex_;
+        std :: unordered_map<crow :: websocket :: connection*, Subscription> subscribers_;
+
+        // polls the data file for appended time steps while serving
+        std :: thread                           watcher_;
+        std :: mutex                            watchMutex_;
+        std :: condition_variable               watchWake_;
+        bool                                    watchStop_          =   false;
+        std :: atomic<size_t>                   publishedTimeSize_{ 0 };
+        uintmax_t                               watchedSize_        =   0;
+        std :: filesystem :: file_time_type     watchedTime_;
+
+        // upper bounds of the spool files being written, see spooledResponse
+        std :: atomic<uint64_t>     spoolReserved_{ 0 };
+
         // class variables
         const std :: string         fileName_;
-        const NcFile                dataFile_;
+        std :: unique_ptr<NcFile>   dataFile_;
         static thread_local uint    timeIndex_; 
         static thread_local uint    zIndex_;
 
         static thread_local uint    responseCode_;
 
-        crow :: SimpleApp           app_;
+        // spool file behind the response the calling thread's handler returned, see offload
+        static thread_local std :: string   spooledPath_;
+
+        crow :: App<RateLimiter>    app_;
+
+        // runs route handlers off the IO threads, created by run / runAsync
+        std :: unique_ptr<ComputePool>  computePool_;
+
+        // per route deadlines, from ROUTE_DEADLINES_MS unless set with setDeadline
+        std :: unordered_map<std :: string, uint>   deadlinesMs_{ ROUTE_DEADLINES_MS };
 
         // storage for concentration doubles - 
         // will be initialized via resize 
@@ -101,12 +425,29 @@ class NetCDFServer
         static thread_local std :: vector<double>    concentrationData_;
 
         // class functions 
+        void            registerRoutes();
+        static uint     ioThreads( uint threads );
+        static std :: vector<ComputePool :: Class>  computeClasses( uint threads );
+
         Response        handleGetInfo();
         Response        handleGetData( const Request& request );
         Response        handleGetImage( const Request& request );
+        Response        handleGetStats( const Request& request );
+        Response        handleGetDose( const Request& request );
+        Response        handleGetContours( const Request& request );
+        Response        handleGetExceedance( const Request& request );
+        Response        handleGetRaw( const Request& request );
+        Response        handleGetAnimation( const Request& request );
+
+        bool            parseSubscription( const Request& request, JSONValue& result, Subscription& subscription );
+        void            startWatcher();
+        void            stopWatcher();
+        void            watchTimeSteps();
+        void            publishNewTimeSteps();
 
         JSONValue       generateVisual( const std :: vector<std :: vector<double>>& grid, 
-                                        const std :: string& outputPath ); 
+                                        const std :: string& outputPath,
+                                        const std :: pair<double, double>& colorRange ); 
 
         std :: string   generateUniqueFileName( const std :: string& path, const std :: string& extension );
 
@@ -116,16 +457,128 @@ class NetCDFServer
 
         JSONValue       extractNetCDFSlice( uint& timeIndex, uint& zIndex );
 
+        std :: shared_ptr<const std :: vector<double>>   readSlice( uint timeIndex, uint zIndex );
+        static uint64_t sliceKey( uint timeIndex, uint zIndex );
+
+        void            loadCoordinates();
+        std :: shared_ptr<const DatasetVersion>     loadDatasetVersion( const DatasetVersion* previous );
+        std :: shared_ptr<const DatasetVersion>     dataset() const;
+
+        std :: shared_ptr<const std :: vector<double>>   cumulativeDose( size_t timeIndex, size_t zIndex );
+
+        JSONList        to2DJSON( const std :: vector<double>& vector1D, size_t rows, size_t cols );
+        static JSONValue    jsonNumber( double value );
+        void            readConcentration( size_t timeStart, 
+                                           size_t timeCount, 
+                                           size_t zIndex, 
+                                           const Region& region, 
+                                           double* values );
+
+        void            readByteRange( size_t timeStart, 
+                                       size_t zIndex, 
+                                       uint64_t first, 
+                                       uint64_t last, 
+                                       std :: ostream& out );
+
+        void            writeSeriesJSON( size_t timeStart, size_t timeEnd, size_t zIndex, std :: ostream& out );
+
         void            extractDimensions( JSONValue& result );
         void            extractVariables( JSONValue& result );
         void            extractGlobalAttributes( JSONValue& result );
+        void            extractSliceSummary( JSONValue& result, const SliceSummaryIndex& summaryIndex );
 
         bool            validateRequestParameters( const Request& request, 
                                                    JSONValue& result,
                                                    uint& timeIndex,
-                                                   uint& zIndex );
+                                                   uint& zIndex,
+                                                   const std :: vector<std :: string>& optionalParameters = {} );
+
+        bool            parseRegion( const Request& request, JSONValue& result, Region& region );
+
+        bool            parseColorScaling( const Request& request, 
+                                           JSONValue& result, 
+                                           size_t zIndex, 
+                                           const Colormap*& colormap, 
+                                           ColorScaling& scaling );
+
+        static const std :: string&     colorCacheControl( const Request& request );
+
+        bool            parseImageFormat( const Request& request, 
+                                          JSONValue& result, 
+                                          ImageFormat& format, 
+                                          int& quality,
+                                          std :: vector<double>& levels );
+
+        static ImageFormat      negotiateFormat( const std :: string& accept );
+
+        bool            parseImageSize( const Request& request, 
+                                        JSONValue& result, 
+                                        size_t& width, 
+                                        size_t& height, 
+                                        ResampleFilter& filter );
+
+        std :: vector<uint8_t>  renderRGBA( const double* plane, 
+                                            size_t ny, 
+                                            size_t nx,
+                                            const Colormap& colormap, 
+                                            const ColorScaling& scaling );
+
+        static std :: string    encodeImage( const std :: vector<uint8_t>& rgba, 
+                                             size_t width, 
+                                             size_t height, 
+                                             const Colormap& colormap,
+                                             ImageFormat format = ImageFormat :: PNG,
+                                             int quality = 0 );
+
+        void            writeSVG( std :: ostream& out,
+                                  const double* plane,
+                                  const Colormap& colormap, 
+                                  const ColorScaling& scaling,
+                                  const std :: vector<double>& levels,
+                                  double plotWidth,
+                                  double plotHeight );
+
+        bool            parseTimeEnd( const Request& request, JSONValue& result, uint timeIndex, uint& timeEnd );
+
+        static ByteRange    parseByteRange( const std :: string& header, uint64_t size, uint64_t& first, uint64_t& last );
+
+        static bool     parseIndex( const char* text, size_t limit, size_t& value );
+        static bool     parseDoubleList( const char* text, std :: vector<double>& values );
+        static std :: vector<double>    cellWidths( const std :: vector<double>& coords );
+
+        Response        instrumented( size_t route, 
+                                      const Request& request, 
+                                      const std :: string& cacheControl,
+                                      const std :: function<Response()>& handler,
+                                      const std :: string& vary = "",
+                                      uint64_t queuedMicros = 0 );
+
+        Cost            estimateCost( const Request& request, const std :: string& vary ) const;
+
+        Response        cancelledResponse( const RequestCancelled& cancelled );
+        Response        busyResponse( const std :: string& error );
+
+        void            offload     ( size_t route, 
+                                      const Request& request, 
+                                      Response& response,
+                                      const std :: string& cacheControl,
+                                      std :: function<Response()> handler,
+                                      const std :: string& vary = "" );
+
+        void            watchConnection( const Request& request, 
+                                         Response& response, 
+                                         std :: shared_ptr<CancelToken> token, 
+                                         std :: shared_ptr<bool> sent );
+
+        std :: string   datasetTag() const;
+        std :: string   entityTag( const Request& request, const std :: string& vary = "" ) const;
+        static std :: string    canonicalQuery( const Request& request );
+        static bool     etagMatches( const std :: string& ifNoneMatch, const std :: string& etag );
 
         Response        JSONResponse( JSONValue& json, const std :: string& contentType );
+        Response        bodyResponse( const std :: string& body, const std :: string& contentType );
+        Response        spooledResponse( const std :: string& extension, uint64_t maxBytes, const std :: function<void( std :: ostream& )>& writer );
+        static uint64_t sweepSpool();
 };
 
 #endif
\ No newline at end of file
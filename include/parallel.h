@@ -0,0 +1,141 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include "cancellation.h"
+#include "compute_pool.h"
+#include "metrics.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// indices and first failure shared by parallelFor's caller and its helpers
+struct ParallelState
+{
+    std :: atomic<size_t>           next{ 0 };
+    std :: exception_ptr            failure;
+
+    // helpers only join while open, the caller waits for active ones once it closes
+    std :: mutex                    mutex;
+    std :: condition_variable       idle;
+    size_t                          active  =   0;
+    bool                            closed  =   false;
+};
+
+/*!
+    Run function( i ) for i in [0, count) on the calling thread and up to
+    hardware_concurrency() - 1 helper threads. Indices are handed out dynamically so
+    uneven work still balances, and the first exception thrown by any of them is
+    rethrown here. Helpers run under the caller's CancelToken and stop between indices
+    once it is cancelled, and record their phases against the caller's metrics route.
+
+    Called from a ComputePool task, the helpers are helper tasks of the same class on the
+    same pool instead of new threads, so the class's concurrency bound holds while the
+    queue that admits requests is left alone. They are only an offer: the caller works
+    through whatever indices are left, and a helper that starts after it has finished
+    returns straight away.
+*/
+template<typename Function>
+void parallelFor( size_t count, Function&& function )
+{
+    const CancelToken*  token   =   CancelToken :: current();
+    size_t              route   =   Metrics :: requestRoute();
+    ComputePool*        pool    =   ComputePool :: current();
+
+    size_t hardware = std :: thread :: hardware_concurrency() > 0 ? std :: thread :: hardware_concurrency() : 4;
+    size_t workers  = std :: min( count, pool ? pool->threads() : hardware );
+
+    if( workers <= 1 )
+    {
+        for( size_t i = 0; i < count; i++ )
+        {
+            if( token )
+                token->check();
+            function( i );
+        }
+        return;
+    }
+
+    auto state = std :: make_shared<ParallelState>();
+
+    auto drain = [ &function, count, token, route ]( ParallelState& shared )
+    {
+        CancelToken :: Scope    scope( token );
+        Metrics :: RouteScope   routeScope( route );
+        try
+        {
+            for( size_t i = shared.next++; i < count; i = shared.next++ )
+            {
+                if( token )
+                    token->check();
+                function( i );
+            }
+        }
+        catch( ... )
+        {
+            std :: lock_guard<std :: mutex> lock( shared.mutex );
+            if( !shared.failure )
+                shared.failure = std :: current_exception();
+
+            // drain the remaining indices so the others stop early
+            shared.next = count;
+        }
+    };
+
+    // function is only touched while the caller waits for this helper
+    auto helper = [ state, drain ]
+    {
+        {
+            std :: lock_guard<std :: mutex> lock( state->mutex );
+            if( state->closed )
+                return;
+            state->active++;
+        }
+
+        drain( *state );
+
+        {
+            std :: lock_guard<std :: mutex> lock( state->mutex );
+            state->active--;
+        }
+        state->idle.notify_all();
+    };
+
+    std :: vector<std :: thread> threads;
+    if( pool )
+    {
+        for( size_t i = 1; i < workers; i++ )
+        {
+            if( !pool->trySubmitHelper( ComputePool :: currentPriority(), helper ) )
+                break;
+        }
+    }
+    else
+    {
+        threads.reserve( workers - 1 );
+        for( size_t i = 1; i < workers; i++ )
+            threads.emplace_back( helper );
+    }
+
+    drain( *state );
+
+    {
+        std :: unique_lock<std :: mutex> lock( state->mutex );
+        state->closed = true;
+        state->idle.wait( lock, [ & ] { return state->active == 0; } );
+    }
+
+    for( auto& thread : threads )
+        thread.join();
+
+    if( state->failure )
+        std :: rethrow_exception( state->failure );
+}
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef PHASE_TIMER_H
+#define PHASE_TIMER_H
+
+#include "metrics.h"
+
+#include <chrono>
+
+/*!
+    Times the enclosing scope as one phase of the current request, feeding both the 
+    route's histograms and the request's Server-Timing header. switchTo() closes the 
+    running phase and opens the next one without a new scope.
+    Use through the TIME_PHASE macros, which compile to nothing unless the build 
+    defines NETCDF_SERVER_TIMING.
+*/
+class ScopedPhase
+{
+    public:
+        explicit ScopedPhase( Metrics :: Phase phase ) : phase_( phase ), start_( std :: chrono :: steady_clock :: now() )
+        {
+        }
+
+        ~ScopedPhase()
+        {
+            record();
+        }
+
+        void switchTo( Metrics :: Phase phase )
+        {
+            record();
+            phase_ = phase;
+            start_ = std :: chrono :: steady_clock :: now();
+        }
+
+        ScopedPhase( const ScopedPhase& ) = delete;
+        ScopedPhase& operator=( const ScopedPhase& ) = delete;
+
+    private:
+        Metrics :: Phase                            phase_;
+        std :: chrono :: steady_clock :: time_point start_;
+
+        void record()
+        {
+            auto elapsed = std :: chrono :: steady_clock :: now() - start_;
+            Metrics :: recordPhase( phase_, std :: chrono :: duration_cast<std :: chrono :: microseconds>( elapsed ).count() );
+        }
+};
+
+#define PHASE_TIMER_CONCAT_( a, b )     a##b
+#define PHASE_TIMER_CONCAT( a, b )      PHASE_TIMER_CONCAT_( a, b )
+
+#ifdef NETCDF_SERVER_TIMING
+    #define TIME_PHASE( phase )                 ScopedPhase PHASE_TIMER_CONCAT( scopedPhase_, __LINE__ )( phase )
+    #define TIME_PHASE_NAMED( name, phase )     ScopedPhase name( phase )
+    #define TIME_PHASE_SWITCH( name, phase )    name.switchTo( phase )
+#else
+    #define TIME_PHASE( phase )                 static_cast<void>( 0 )
+    #define TIME_PHASE_NAMED( name, phase )     static_cast<void>( 0 )
+    #define TIME_PHASE_SWITCH( name, phase )    static_cast<void>( 0 )
+#endif
+
+#endif
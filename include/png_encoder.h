@@ -0,0 +1,64 @@
+#ifndef PNG_ENCODER_H
+#define PNG_ENCODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// PNG row filter, ADAPTIVE picks per row the one with the smallest sum of absolute residuals
+enum class PNGFilter
+{
+    NONE,
+    SUB,
+    UP,
+    AVERAGE,
+    PAETH,
+    ADAPTIVE
+};
+
+// zlib deflate strategy, RLE suits the long flat runs of colormapped fields
+enum class PNGStrategy
+{
+    DEFAULT,
+    FILTERED,
+    RLE,
+    HUFFMAN_ONLY
+};
+
+struct PNGOptions
+{
+    int             level       =   6;      // zlib level, 0 - 9
+    PNGStrategy     strategy    =   PNGStrategy :: DEFAULT;
+    PNGFilter       filter      =   PNGFilter :: NONE;
+};
+
+/*!
+    8 bit RGBA rows ( top row first, width * 4 bytes each ) to a complete PNG file.
+    Rows are filtered and deflated straight from the caller's buffer.
+*/
+std :: string   encodePNG( const uint8_t* rgba, uint32_t width, uint32_t height, const PNGOptions& options = {} );
+
+/*!
+    8 bit palette index rows ( width bytes each ) to an indexed color PNG. palette holds 
+    up to 256 entries as R | G << 8 | B << 16 | A << 24; alpha is written ( tRNS ) only 
+    up to the last entry that is not opaque.
+*/
+std :: string   encodeIndexedPNG( const uint8_t* indices, 
+                                  uint32_t width, 
+                                  uint32_t height, 
+                                  const std :: vector<uint32_t>& palette, 
+                                  const PNGOptions& options = {} );
+
+/*!
+    Animated PNG, looping forever, each frame a full RGBA image of the same size replacing 
+    the previous one. Frames are deflated in parallel; browsers without APNG support show 
+    the first frame.
+*/
+std :: string   encodeAPNG( const std :: vector<const uint8_t*>& frames, 
+                            uint32_t width, 
+                            uint32_t height, 
+                            uint16_t delayMs, 
+                            const PNGOptions& options = {} );
+
+#endif
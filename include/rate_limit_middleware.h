@@ -0,0 +1,286 @@
+#ifndef RATE_LIMIT_MIDDLEWARE_H
+#define RATE_LIMIT_MIDDLEWARE_H
+
+#include "crow/http_request.h"
+#include "crow/http_response.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*!
+    Crow middleware limiting each client, identified by an API key header when it sends
+    one and by its IP address otherwise, to a token bucket of requests ( rate per second,
+    up to burst at once ) and to a number of expensive requests in flight. Requests over
+    either limit get 429 with Retry-After before any handler runs. Behind a load balancer 
+    or reverse proxy listed in trustedProxies the address is taken from X-Forwarded-For: 
+    the rightmost entry that is not itself a trusted proxy, since entries further left 
+    come from the client and may be forged.
+
+    Client state lives in a fixed table of cache line sized slots, split into shards by
+    key hash and probed linearly within a shard. Slots are claimed, charged and released
+    with atomic compare and swap only, so the check takes no lock. A client idle for
+    IDLE_MS with nothing in flight gives up its slot to a new one; when a shard has no
+    slot to give the request is let through ( fail open ).
+
+    usage:
+        crow :: App<RateLimiter> app;
+        app.get_middleware<RateLimiter>().rate( 20, 40 ).maxInFlight( 2 ).expensive( predicate ).trustedProxies( { "10.0.0.2" } );
+*/
+struct RateLimiter
+{
+    static constexpr size_t     SHARDS          =   16;
+    static constexpr size_t     SHARD_SLOTS     =   1024;
+    static constexpr size_t     MAX_PROBE       =   16;
+    static constexpr uint64_t   IDLE_MS         =   60000;
+
+    static constexpr char       TOO_MANY[]      =   "RateLimiter :: before_handle: Too many requests from this client, retry after Retry-After seconds. ";
+    static constexpr char       IN_FLIGHT[]     =   "RateLimiter :: before_handle: Too many expensive requests in flight from this client. ";
+
+    struct context
+    {
+        // slot charged with an in-flight expensive request, released in after_handle
+        void*   inFlight    =   nullptr;
+    };
+
+    RateLimiter() : start_( std :: chrono :: steady_clock :: now() ), shards_( std :: make_unique<Shard[]>( SHARDS ) )
+    {
+    }
+
+    // tokens per second ( fractions allowed ) and bucket size, burst is capped at MAX_BURST; perSecond = 0 turns the rate limit off
+    RateLimiter& rate( double perSecond, double burst )
+    {
+        perMs_  =   std :: max( 0.0, perSecond );
+        burst_  =   std :: min<uint64_t>( MAX_BURST, static_cast<uint64_t>( std :: max( 1.0, burst ) ) ) * TOKEN;
+        return *this;
+    }
+
+    // expensive requests a client may have in flight, 0 = no limit
+    RateLimiter& maxInFlight( uint32_t requests )
+    {
+        maxInFlight_ = requests;
+        return *this;
+    }
+
+    // which requests count against maxInFlight
+    RateLimiter& expensive( std :: function<bool( const crow :: request& )> predicate )
+    {
+        expensive_ = std :: move( predicate );
+        return *this;
+    }
+
+    // header carrying the API key, when present it identifies the client instead of the address
+    RateLimiter& apiKeyHeader( const std :: string& header )
+    {
+        apiKeyHeader_ = header;
+        return *this;
+    }
+
+    // addresses of the proxies whose X-Forwarded-For is believed, as crow reports them
+    RateLimiter& trustedProxies( std :: vector<std :: string> addresses )
+    {
+        trustedProxies_ = std :: move( addresses );
+        return *this;
+    }
+
+    void before_handle( crow :: request& request, crow :: response& response, context& ctx )
+    {
+        ctx.inFlight = nullptr;
+
+        if( perMs_ <= 0.0 && maxInFlight_ == 0 )
+            return;
+
+        uint64_t    now     =   nowMs();
+        Slot*       slot    =   find( clientKey( request ), now );
+        if( !slot )
+            return;
+
+        uint64_t waitMs = 0;
+        if( perMs_ > 0.0 && !take( *slot, now, waitMs ) )
+        {
+            reject( response, ( waitMs + 999 ) / 1000, TOO_MANY );
+            return;
+        }
+
+        if( maxInFlight_ == 0 || !expensive_ || !expensive_( request ) )
+            return;
+
+        if( slot->inFlight.fetch_add( 1 ) >= maxInFlight_ )
+        {
+            slot->inFlight.fetch_sub( 1 );
+            reject( response, 1, IN_FLIGHT );
+            return;
+        }
+        ctx.inFlight = slot;
+    }
+
+    void after_handle( crow :: request&, crow :: response&, context& ctx )
+    {
+        if( ctx.inFlight )
+            static_cast<Slot*>( ctx.inFlight )->inFlight.fetch_sub( 1 );
+        ctx.inFlight = nullptr;
+    }
+
+    private:
+        // bucket word: milliseconds since start_ << TOKEN_BITS | tokens in 1 / TOKEN units
+        static constexpr uint64_t   TOKEN_BITS  =   24;
+        static constexpr uint64_t   TOKEN_MASK  =   ( uint64_t( 1 ) << TOKEN_BITS ) - 1;
+        static constexpr uint64_t   TOKEN       =   1000;
+        static constexpr uint64_t   MAX_BURST   =   TOKEN_MASK / TOKEN;
+
+        struct alignas( 64 ) Slot
+        {
+            std :: atomic<uint64_t>     key{ 0 };
+            std :: atomic<uint64_t>     bucket{ 0 };
+            std :: atomic<uint32_t>     inFlight{ 0 };
+        };
+
+        using Shard = std :: array<Slot, SHARD_SLOTS>;
+
+        uint64_t nowMs() const
+        {
+            return std :: chrono :: duration_cast<std :: chrono :: milliseconds>( std :: chrono :: steady_clock :: now() - start_ ).count();
+        }
+
+        bool trusted( const std :: string& address ) const
+        {
+            return std :: find( trustedProxies_.begin(), trustedProxies_.end(), address ) != trustedProxies_.end();
+        }
+
+        // the peer, or when it is a trusted proxy the nearest untrusted X-Forwarded-For entry
+        std :: string clientAddress( const crow :: request& request ) const
+        {
+            if( !trusted( request.remote_ip_address ) )
+                return request.remote_ip_address;
+
+            const std :: string&    forwarded   =   request.get_header_value( "X-Forwarded-For" );
+            std :: string           address     =   request.remote_ip_address;
+            size_t                  end         =   forwarded.size();
+
+            while( end > 0 )
+            {
+                size_t      comma   =   forwarded.rfind( ',', end - 1 );
+                size_t      begin   =   comma == std :: string :: npos ? 0 : comma + 1;
+                std :: string entry =   forwarded.substr( begin, end - begin );
+
+                entry.erase( 0, entry.find_first_not_of( " \t" ) );
+                entry.erase( entry.find_last_not_of( " \t" ) + 1 );
+                if( !entry.empty() )
+                {
+                    address = entry;
+                    if( !trusted( entry ) )
+                        break;
+                }
+
+                if( comma == std :: string :: npos )
+                    break;
+                end = comma;
+            }
+            return address;
+        }
+
+        // 64 bit FNV-1a, never 0 ( the free slot marker ); keys and addresses hash apart
+        uint64_t clientKey( const crow :: request& request ) const
+        {
+            const std :: string&    apiKey  =   apiKeyHeader_.empty() ? apiKeyHeader_ : request.get_header_value( apiKeyHeader_ );
+            const std :: string     client  =   apiKey.empty() ? clientAddress( request ) : apiKey;
+
+            uint64_t hash = apiKey.empty() ? 14695981039346656037ull : 1099511628211ull;
+            for( unsigned char c : client )
+            {
+                hash ^= c;
+                hash *= 1099511628211ull;
+            }
+            return hash | 1;
+        }
+
+        // the client's slot, claiming a free or idle one; nullptr when its probe window is taken
+        Slot* find( uint64_t key, uint64_t now )
+        {
+            Shard&  shard   =   shards_[ key % SHARDS ];
+            size_t  first   =   ( key / SHARDS ) % SHARD_SLOTS;
+
+            for( size_t probe = 0; probe < MAX_PROBE; probe++ )
+            {
+                Slot&       slot    =   shard[ ( first + probe ) % SHARD_SLOTS ];
+                uint64_t    current =   slot.key.load( std :: memory_order_acquire );
+
+                if( current == key )
+                    return &slot;
+
+                bool idle = current == 0 ||
+                            ( slot.inFlight.load( std :: memory_order_relaxed ) == 0 &&
+                              now - std :: min( now, slot.bucket.load( std :: memory_order_relaxed ) >> TOKEN_BITS ) > IDLE_MS );
+                if( !idle )
+                    continue;
+
+                if( slot.key.compare_exchange_strong( current, key, std :: memory_order_acq_rel ) )
+                {
+                    slot.bucket.store( std :: max<uint64_t>( 1, now ) << TOKEN_BITS | burst_, std :: memory_order_relaxed );
+                    return &slot;
+                }
+
+                // lost the race, possibly to the same client
+                if( current == key )
+                    return &slot;
+            }
+            return nullptr;
+        }
+
+        // 1 / TOKEN units issued by now ms in total; refills credit the difference, so fractional rates lose nothing
+        uint64_t minted( uint64_t now ) const
+        {
+            return static_cast<uint64_t>( std :: floor( now * perMs_ ) );
+        }
+
+        // refill for the time passed and take one token, else waitMs until one is due
+        bool take( Slot& slot, uint64_t now, uint64_t& waitMs ) const
+        {
+            uint64_t word = slot.bucket.load( std :: memory_order_relaxed );
+            while( true )
+            {
+                uint64_t last   =   word >> TOKEN_BITS;
+                uint64_t tokens =   std :: min( burst_, ( word & TOKEN_MASK ) + ( now > last ? minted( now ) - minted( last ) : 0 ) );
+
+                if( tokens < TOKEN )
+                {
+                    waitMs = static_cast<uint64_t>( std :: ceil( ( TOKEN - tokens ) / perMs_ ) );
+                    return false;
+                }
+
+                uint64_t next = std :: max( now, last ) << TOKEN_BITS | ( tokens - TOKEN );
+                if( slot.bucket.compare_exchange_weak( word, next, std :: memory_order_relaxed ) )
+                    return true;
+            }
+        }
+
+        static void reject( crow :: response& response, uint64_t retryAfterS, const char* error )
+        {
+            response.code = 429;
+            response.set_header( "Retry-After", std :: to_string( std :: max<uint64_t>( 1, retryAfterS ) ) );
+            response.set_header( "Content-Type", "application/json" );
+            response.set_header( "Cache-Control", "no-cache, no-store" );
+            response.body = std :: string( "{\"error\": \"" ) + error + "\"}";
+            response.end();
+        }
+
+        // tokens per millisecond in 1 / TOKEN units, i.e. tokens per second
+        double                                          perMs_          =   20.0;
+        uint64_t                                        burst_          =   40 * TOKEN;
+        uint32_t                                        maxInFlight_    =   0;
+        std :: function<bool( const crow :: request& )> expensive_;
+        std :: string                                   apiKeyHeader_   =   "X-API-Key";
+        std :: vector<std :: string>                    trustedProxies_;
+
+        const std :: chrono :: steady_clock :: time_point   start_;
+        std :: unique_ptr<Shard[]>                      shards_;
+};
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef REDUCTIONS_H
+#define REDUCTIONS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+/*!
+    Mergeable single-pass moments over a run of doubles.
+    add() reduces fixed-size blocks with plain loops the compiler can vectorize,
+    then folds each block in with Chan's parallel form of Welford's update, so
+    partial results from independent threads can be merged exactly. NaN is skipped.
+*/
+struct RunningStats
+{
+    uint64_t    count   =   0;
+    uint64_t    nonzero =   0;
+    double      sum     =   0.0;
+    double      mean    =   0.0;
+    double      m2      =   0.0;
+    double      min     =   std :: numeric_limits<double> :: infinity();
+    double      max     =   -std :: numeric_limits<double> :: infinity();
+
+    void        add     ( const double* values, size_t size );
+    void        merge   ( const RunningStats& other );
+
+    // population variance
+    double      variance() const;
+};
+
+/*!
+    Approximate distribution for percentiles, filled in the same pass as RunningStats.
+    Positive values are bucketed straight from their IEEE-754 exponent and top mantissa
+    bits, giving ~3% relative resolution over many orders of magnitude without having
+    to know the data range up front. Non-positive values share a single bucket.
+*/
+class LogHistogram
+{
+    public:
+        LogHistogram();
+
+        void        add     ( const double* values, size_t size );
+        void        merge   ( const LogHistogram& other );
+
+        // q in [0, 1]; lo and hi are the exact min and max used to clamp the estimate
+        double      quantile( double q, double lo, double hi ) const;
+
+        uint64_t    count() const { return total_; }
+
+    private:
+        static constexpr int    kSubBucketBits  =   5;
+        static constexpr int    kMinExponent    =   -160;
+        static constexpr int    kMaxExponent    =   128;
+        static constexpr size_t kBucketCount    =   size_t( kMaxExponent - kMinExponent ) << kSubBucketBits;
+
+        std :: vector<uint64_t> buckets_;
+        uint64_t                nonPositive_    =   0;
+        uint64_t                underflow_      =   0;
+        uint64_t                overflow_       =   0;
+        uint64_t                total_          =   0;
+
+        static double           bucketLowerBound( size_t index );
+};
+
+/*!
+    Pack values[ i ] >= level into mask, bit i % 64 of word i / 64 ( LSB first ), and 
+    return the number of set bits. mask must hold ( size + 63 ) / 64 words; padding bits 
+    in the last word are cleared. NaN never exceeds. Uses AVX2 compare + movemask when 
+    built with it, a branch-free scalar loop otherwise, and popcount on whole words.
+*/
+uint64_t    thresholdMask( const double* values, size_t size, double level, uint64_t* mask );
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef RESAMPLE_H
+#define RESAMPLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class ResampleFilter
+{
+    NEAREST,
+    BILINEAR
+};
+
+/*!
+    Where each output pixel along one axis samples the source: value = 
+    src[ first ] + weight * ( src[ second ] - src[ first ] ). Pixels are spread evenly over 
+    the physical extent of the cells ( see axisExtent ), so non-uniform coordinates are 
+    followed and an integer upscale with NEAREST repeats every cell exactly.
+*/
+struct ResampleAxis
+{
+    std :: vector<uint32_t> first;
+    std :: vector<uint32_t> second;
+    std :: vector<double>   weight;
+};
+
+// span from the outer edge of the first cell to the outer edge of the last, coords ascending
+double          axisExtent  ( const std :: vector<double>& coords );
+
+// the n + 1 cell boundaries, half way between nodes and half a spacing past the ends
+std :: vector<double>   cellEdges( const std :: vector<double>& coords );
+
+ResampleAxis    resampleAxis( const std :: vector<double>& coords, size_t size, ResampleFilter filter );
+
+/*!
+    Separable resample of a C order plane with rows.size() x cols.size() output. Each 
+    source row that is needed is resampled horizontally once into a two row cache, then 
+    output rows are blends of the cached pair; both inner loops are plain arrays that 
+    vectorize. out holds rows.first.size() * cols.first.size() values.
+*/
+void            resample    ( const double* plane, size_t nx, const ResampleAxis& rows, const ResampleAxis& cols, double* out );
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+/*!
+    Bounded key/value cache for computed responses. Readers share the lock, 
+    values are handed out as shared_ptr<const Value> so a hit never copies the 
+    payload, and the oldest entry is evicted once capacity is reached.
+*/
+template<typename Key, typename Value>
+class ResultCache
+{
+    public:
+        using Entry = std :: shared_ptr<const Value>;
+
+        explicit ResultCache( size_t capacity = 256 ) : capacity_( capacity )
+        {
+        }
+
+        // nullptr on miss
+        Entry find( const Key& key ) const
+        {
+            std :: shared_lock lock( mutex_ );
+            auto it = entries_.find( key );
+            return it != entries_.end() ? it->second : nullptr;
+        }
+
+        // first writer wins, so concurrent misses all return the same entry
+        Entry insert( const Key& key, Value value )
+        {
+            return insert( key, std :: make_shared<const Value>( std :: move( value ) ) );
+        }
+
+        // same, for a value already shared elsewhere, which is kept rather than copied
+        Entry insert( const Key& key, Entry entry )
+        {
+            std :: unique_lock lock( mutex_ );
+            auto [ it, inserted ] = entries_.emplace( key, entry );
+            if( !inserted )
+                return it->second;
+
+            order_.push_back( key );
+            while( order_.size() > capacity_ )
+            {
+                entries_.erase( order_.front() );
+                order_.pop_front();
+            }
+            return entry;
+        }
+
+        void clear()
+        {
+            std :: unique_lock lock( mutex_ );
+            entries_.clear();
+            order_.clear();
+        }
+
+        size_t size() const
+        {
+            std :: shared_lock lock( mutex_ );
+            return entries_.size();
+        }
+
+    private:
+        const size_t                        capacity_;
+        std :: unordered_map<Key, Entry>    entries_;
+        std :: deque<Key>                   order_;
+        mutable std :: shared_mutex         mutex_;
+};
+
+#endif
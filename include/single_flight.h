@@ -0,0 +1,100 @@
+#ifndef SINGLE_FLIGHT_H
+#define SINGLE_FLIGHT_H
+
+#include "cancellation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+/*!
+    Coalesces concurrent calls for the same key: the first caller runs the work, 
+    callers arriving while it is in flight wait on a shared future and get the same 
+    immutable result ( or the same exception ). Nothing is kept once the call lands, 
+    caching is left to the caller. When the first caller's request is cancelled the 
+    others are not: they call again and one of them takes over the work. A waiting 
+    caller still answers to its own CancelToken, checked every FOLLOWER_POLL and at 
+    its deadline, and leaves the work running for the rest when it gives up.
+*/
+template<typename Key, typename Value>
+class SingleFlight
+{
+    public:
+        using Result = std :: shared_ptr<const Value>;
+
+        static constexpr std :: chrono :: milliseconds   FOLLOWER_POLL{ 50 };
+
+        // coalesced is set when this call reused another caller's in-flight work
+        template<typename Function>
+        Result run( const Key& key, Function&& function, bool& coalesced )
+        {
+            std :: promise<Result>          promise;
+            std :: shared_future<Result>    future;
+            while( true )
+            {
+                std :: unique_lock lock( mutex_ );
+
+                auto it = calls_.find( key );
+                if( it != calls_.end() )
+                {
+                    future = it->second;
+                    lock.unlock();
+
+                    // throws RequestCancelled once this caller's own request is cancelled
+                    if( const CancelToken* token = CancelToken :: current() )
+                    {
+                        while( future.wait_until( std :: min( token->deadline(), CancelToken :: Clock :: now() + FOLLOWER_POLL ) ) != std :: future_status :: ready )
+                            token->check();
+                    }
+
+                    try
+                    {
+                        Result result = future.get();
+                        coalesced = true;
+                        return result;
+                    }
+                    catch( const RequestCancelled& )
+                    {
+                        // the work was abandoned for its own request, not for this one
+                        continue;
+                    }
+                }
+
+                coalesced   =   false;
+                future      =   promise.get_future().share();
+                calls_.emplace( key, future );
+                break;
+            }
+
+            try
+            {
+                promise.set_value( std :: make_shared<const Value>( function() ) );
+            }
+            catch( ... )
+            {
+                // unlisted first, so callers retrying after a cancellation do not find it again
+                {
+                    std :: lock_guard lock( mutex_ );
+                    calls_.erase( key );
+                }
+                promise.set_exception( std :: current_exception() );
+                return future.get();
+            }
+
+            {
+                std :: lock_guard lock( mutex_ );
+                calls_.erase( key );
+            }
+            return future.get();
+        }
+
+    private:
+        std :: mutex                                            mutex_;
+        std :: unordered_map<Key, std :: shared_future<Result>> calls_;
+};
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef SLICE_SUMMARY_H
+#define SLICE_SUMMARY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// reduced view of one ( time, z ) plane
+struct SliceSummary
+{
+    double      min     =   0.0;
+    double      max     =   0.0;
+    double      mean    =   0.0;
+    uint64_t    nonzero =   0;
+};
+
+/*!
+    Per-slice min/max/mean/nonzero table for the whole concentration variable.
+    Built once in parallel across slices, then persisted to a text sidecar next to
+    the data file and keyed on the file's size and modification time, so a restart
+    against an unchanged file loads the table instead of rescanning every slice. When
+    time steps are appended only the new slices are scanned.
+*/
+class SliceSummaryIndex
+{
+    public:
+        // fills values with the ( y, x ) plane for ( time, z ), called from worker threads
+        using PlaneReader = std :: function<void( size_t timeIndex, size_t zIndex, double* values )>;
+
+        // load the sidecar if it matches the data file, otherwise build and save it; the 
+        // time steps previous ( the index of the same file before it grew ) covers are not read again
+        void                    loadOrBuild ( const std :: string& dataPath,
+                                              size_t timeSize,
+                                              size_t zSize,
+                                              size_t planeSize,
+                                              const PlaneReader& reader,
+                                              const SliceSummaryIndex* previous = nullptr );
+
+        bool                    empty       () const { return slices_.empty(); }
+        size_t                  timeSize    () const { return timeSize_; }
+        size_t                  zSize       () const { return zSize_; }
+
+        const SliceSummary&     at          ( size_t timeIndex, size_t zIndex ) const;
+
+        // min and max over every time step at one level, the fixed color scale for that level
+        std :: pair<double, double> range   ( size_t zIndex ) const;
+
+        static std :: string    sidecarPath ( const std :: string& dataPath );
+
+    private:
+        size_t                          timeSize_   =   0;
+        size_t                          zSize_      =   0;
+        std :: vector<SliceSummary>     slices_;
+
+        bool                    load        ( const std :: string& path, uint64_t fileSize, int64_t fileTime );
+        void                    save        ( const std :: string& path, uint64_t fileSize, int64_t fileTime ) const;
+};
+
+#endif
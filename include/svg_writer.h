@@ -0,0 +1,76 @@
+#ifndef SVG_WRITER_H
+#define SVG_WRITER_H
+
+#include "contours.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*!
+    Streams an SVG document straight into out, holding no more than one row of cells.
+    Coordinates are canvas units ( y down ), colors R | G << 8 | B << 16 | A << 24 as 
+    the colormap tables store them; fully transparent cells are left out.
+    Cell rows are merged as they arrive: a run of equal colors in a row becomes one 
+    rectangle, and a rectangle keeps growing down while the rows below repeat the same 
+    run, so uniform regions cost one element whatever the grid size.
+*/
+class SVGWriter
+{
+    public:
+        // writes the document header, width x height canvas units
+        SVGWriter( std :: ostream& out, double width, double height );
+
+        /*!
+            one row of cells, top to bottom: xEdges holds the nx + 1 cell boundaries, 
+            colors the nx cell colors
+        */
+        void    cellRow     ( const std :: vector<double>& xEdges, double top, double bottom, const uint32_t* colors );
+
+        // closes the open cells, call before drawing anything meant to go over them
+        void    endCells    ();
+
+        // closed rings as one stroked path
+        void    rings       ( const std :: vector<Ring>& rings, const std :: string& stroke, double strokeWidth );
+
+        /*!
+            vertical bar, stops are ( position 0 at the bottom - 1 at the top, color ). Smooth 
+            bars interpolate between stops, stepped ones fill each stop up to the next. 
+            ticks are ( position, label ) written to the right of the bar.
+        */
+        void    colorbar    ( double x, double y, double width, double height,
+                              const std :: vector<std :: pair<double, uint32_t>>& stops,
+                              bool stepped,
+                              const std :: vector<std :: pair<double, std :: string>>& ticks );
+
+        // closes any open cells and the document
+        void    finish      ();
+
+    private:
+        // a run of equal colored cells [ first, last ) still open for rows below to extend
+        struct Block
+        {
+            size_t      first;
+            size_t      last;
+            uint32_t    color;
+            double      x0;
+            double      x1;
+            double      top;
+            double      bottom;
+        };
+
+        void    closeBlock  ( const Block& block );
+
+        std :: ostream&         out_;
+        std :: vector<Block>    open_;
+        std :: vector<Block>    next_;
+        size_t                  gradients_  =   0;
+};
+
+// fill color as #rrggbb
+std :: string   svgColor    ( uint32_t color );
+
+#endif
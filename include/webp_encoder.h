@@ -0,0 +1,21 @@
+#ifndef WEBP_ENCODER_H
+#define WEBP_ENCODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// libwebp is optional, builds without NETCDF_SERVER_HAVE_WEBP have no WebP output
+#ifdef NETCDF_SERVER_HAVE_WEBP
+constexpr bool WEBP_AVAILABLE   =   true;
+#else
+constexpr bool WEBP_AVAILABLE   =   false;
+#endif
+
+/*!
+    8 bit RGBA rows ( top row first, width * 4 bytes each ) to a lossy WebP file, alpha 
+    kept. quality is libwebp's, 0 - 100. Throws when WEBP_AVAILABLE is false.
+*/
+std :: string   encodeWebP( const uint8_t* rgba, uint32_t width, uint32_t height, int quality );
+
+#endif
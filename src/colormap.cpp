@@ -0,0 +1,315 @@
+#include "colormap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <memory>
+
+#if defined( __AVX2__ )
+#include <immintrin.h>
+#elif defined( __ARM_NEON ) && defined( __aarch64__ )
+#include <arm_neon.h>
+#define COLORMAP_NEON
+#endif
+
+namespace
+{
+    struct NamedStops
+    {
+        const char*         name;
+        bool                stepped;
+        Colormap :: Stops   stops;
+    };
+
+    const std :: vector<NamedStops>& catalogue()
+    {
+        static const std :: vector<NamedStops> maps =
+        {
+            // matplotlib viridis sampled at ninths, perceptually uniform
+            { "viridis",    false,  { 0x440154, 0x472d7b, 0x3b528b, 0x2c728e, 0x21918c, 0x28ae80, 0x5ec962, 0xaddc30, 0xfde725 } },
+
+            // classic MATLAB jet
+            { "jet",        false,  { 0x000080, 0x0000ff, 0x0080ff, 0x00ffff, 0x80ff80, 0xffff00, 0xff8000, 0xff0000, 0x800000 } },
+
+            // stepped yellow -> dark red, for threshold maps with scale=breaks
+            { "hazard",     true,   { 0xffffb2, 0xfecc5c, 0xfd8d3c, 0xf03b20, 0xbd0026 } },
+
+            // AEGL-1 / AEGL-2 / AEGL-3 style three tier palette
+            { "aegl",       true,   { 0xffd700, 0xff8c00, 0xd00000 } }
+        };
+        return maps;
+    }
+
+    inline uint32_t pack( double r, double g, double b )
+    {
+        auto channel = []( double c ) { return static_cast<uint32_t>( std :: lround( std :: clamp( c, 0.0, 255.0 ) ) ); };
+        return channel( r ) | channel( g ) << 8 | channel( b ) << 16 | 0xffu << 24;
+    }
+
+    // log10( v ) for v > 0 from the exponent and an odd series for ln of the mantissa,
+    // ~1e-6 absolute error; written out so the SIMD paths can match it exactly
+    constexpr double kLog10Of2      =   0.30102999566398119521;
+    constexpr double kLog10OfE      =   0.43429448190325182765;
+    constexpr double kTwoPow52      =   4503599627370496.0;
+
+    inline double lnMantissa( double m )
+    {
+        double s    =   ( m - 1.0 ) / ( m + 1.0 );
+        double s2   =   s * s;
+        return s * ( 2.0 + s2 * ( 2.0 / 3.0 + s2 * ( 2.0 / 5.0 + s2 * ( 2.0 / 7.0 + s2 * ( 2.0 / 9.0 ) ) ) ) );
+    }
+
+    inline double fastLog10( double v )
+    {
+        uint64_t bits;
+        std :: memcpy( &bits, &v, sizeof( bits ) );
+
+        uint64_t    exponentBits    =   ( bits >> 52 ) | 0x4330000000000000ull;
+        uint64_t    mantissaBits    =   ( bits & 0x000fffffffffffffull ) | 0x3ff0000000000000ull;
+        double      exponent, mantissa;
+        std :: memcpy( &exponent, &exponentBits, sizeof( exponent ) );
+        std :: memcpy( &mantissa, &mantissaBits, sizeof( mantissa ) );
+
+        exponent = exponent - kTwoPow52 - 1023.0;
+        return exponent * kLog10Of2 + lnMantissa( mantissa ) * kLog10OfE;
+    }
+
+#if defined( __AVX2__ )
+    inline __m256d fastLog10( __m256d v )
+    {
+        __m256i bits        =   _mm256_castpd_si256( v );
+        __m256d exponent    =   _mm256_castsi256_pd( _mm256_or_si256( _mm256_srli_epi64( bits, 52 ), _mm256_set1_epi64x( 0x4330000000000000ll ) ) );
+        __m256d mantissa    =   _mm256_castsi256_pd( _mm256_or_si256( _mm256_and_si256( bits, _mm256_set1_epi64x( 0x000fffffffffffffll ) ),
+                                                                      _mm256_set1_epi64x( 0x3ff0000000000000ll ) ) );
+        __m256d one         =   _mm256_set1_pd( 1.0 );
+
+        exponent = _mm256_sub_pd( _mm256_sub_pd( exponent, _mm256_set1_pd( kTwoPow52 ) ), _mm256_set1_pd( 1023.0 ) );
+
+        __m256d s   =   _mm256_div_pd( _mm256_sub_pd( mantissa, one ), _mm256_add_pd( mantissa, one ) );
+        __m256d s2  =   _mm256_mul_pd( s, s );
+        __m256d p   =   _mm256_set1_pd( 2.0 / 9.0 );
+        p = _mm256_add_pd( _mm256_set1_pd( 2.0 / 7.0 ), _mm256_mul_pd( s2, p ) );
+        p = _mm256_add_pd( _mm256_set1_pd( 2.0 / 5.0 ), _mm256_mul_pd( s2, p ) );
+        p = _mm256_add_pd( _mm256_set1_pd( 2.0 / 3.0 ), _mm256_mul_pd( s2, p ) );
+        p = _mm256_add_pd( _mm256_set1_pd( 2.0 ),       _mm256_mul_pd( s2, p ) );
+        p = _mm256_mul_pd( s, p );
+
+        return _mm256_add_pd( _mm256_mul_pd( exponent, _mm256_set1_pd( kLog10Of2 ) ), _mm256_mul_pd( p, _mm256_set1_pd( kLog10OfE ) ) );
+    }
+#elif defined( COLORMAP_NEON )
+    inline float64x2_t fastLog10( float64x2_t v )
+    {
+        uint64x2_t  bits        =   vreinterpretq_u64_f64( v );
+        float64x2_t exponent    =   vsubq_f64( vcvtq_f64_u64( vshrq_n_u64( bits, 52 ) ), vdupq_n_f64( 1023.0 ) );
+        float64x2_t mantissa    =   vreinterpretq_f64_u64( vorrq_u64( vandq_u64( bits, vdupq_n_u64( 0x000fffffffffffffull ) ),
+                                                                      vdupq_n_u64( 0x3ff0000000000000ull ) ) );
+        float64x2_t one         =   vdupq_n_f64( 1.0 );
+
+        float64x2_t s   =   vdivq_f64( vsubq_f64( mantissa, one ), vaddq_f64( mantissa, one ) );
+        float64x2_t s2  =   vmulq_f64( s, s );
+        float64x2_t p   =   vdupq_n_f64( 2.0 / 9.0 );
+        p = vaddq_f64( vdupq_n_f64( 2.0 / 7.0 ), vmulq_f64( s2, p ) );
+        p = vaddq_f64( vdupq_n_f64( 2.0 / 5.0 ), vmulq_f64( s2, p ) );
+        p = vaddq_f64( vdupq_n_f64( 2.0 / 3.0 ), vmulq_f64( s2, p ) );
+        p = vaddq_f64( vdupq_n_f64( 2.0 ),       vmulq_f64( s2, p ) );
+        p = vmulq_f64( s, p );
+
+        return vaddq_f64( vmulq_f64( exponent, vdupq_n_f64( kLog10Of2 ) ), vmulq_f64( p, vdupq_n_f64( kLog10OfE ) ) );
+    }
+#endif
+}
+
+Colormap :: Colormap( const Stops& stops, bool stepped, size_t lutSize ) : lut_( lutSize + 1 ), stepped_( stepped )
+{
+    auto channel = []( uint32_t rgb, int shift ) { return static_cast<double>( ( rgb >> shift ) & 0xff ); };
+
+    for( size_t i = 0; i < lutSize; i++ )
+    {
+        double position = static_cast<double>( i ) / static_cast<double>( lutSize - 1 );
+
+        if( stepped )
+        {
+            uint32_t rgb = stops[ std :: min( stops.size() - 1, static_cast<size_t>( position * stops.size() ) ) ];
+            lut_[ i ] = pack( channel( rgb, 16 ), channel( rgb, 8 ), channel( rgb, 0 ) );
+            continue;
+        }
+
+        double  scaled  =   position * static_cast<double>( stops.size() - 1 );
+        size_t  k       =   std :: min( stops.size() - 2, static_cast<size_t>( scaled ) );
+        double  f       =   scaled - static_cast<double>( k );
+
+        auto mix = [ & ]( int shift ) { return channel( stops[ k ], shift ) * ( 1.0 - f ) + channel( stops[ k + 1 ], shift ) * f; };
+        lut_[ i ] = pack( mix( 16 ), mix( 8 ), mix( 0 ) );
+    }
+
+    // transparent
+    lut_[ lutSize ] = 0;
+
+    palette_.assign( PALETTE_SIZE, 0 );
+    paletteIndex_[ lut_[ lutSize ] ] = 0;
+    for( size_t i = 0; i < lutSize; i++ )
+    {
+        auto index = static_cast<uint8_t>( 1 + ( i * ( PALETTE_SIZE - 2 ) + ( lutSize - 1 ) / 2 ) / ( lutSize - 1 ) );
+        palette_[ index ] = lut_[ i ];
+        paletteIndex_.emplace( lut_[ i ], index );
+    }
+}
+
+const Colormap* Colormap :: find( const std :: string& name, size_t lutSize )
+{
+    if( lutSize != SMALL_LUT && lutSize != LARGE_LUT )
+        return nullptr;
+
+    // every table up front, so lookups after first use never lock
+    static const auto tables = []
+    {
+        std :: map<std :: pair<std :: string, size_t>, std :: unique_ptr<Colormap>> built;
+        for( const auto& named : catalogue() )
+        {
+            for( size_t size : { SMALL_LUT, LARGE_LUT } )
+                built[ { named.name, size } ].reset( new Colormap( named.stops, named.stepped, size ) );
+        }
+        return built;
+    }();
+
+    auto it = tables.find( { name, lutSize } );
+    return it == tables.end() ? nullptr : it->second.get();
+}
+
+const std :: vector<std :: string>& Colormap :: names()
+{
+    static const std :: vector<std :: string> list = []
+    {
+        std :: vector<std :: string> names;
+        for( const auto& named : catalogue() )
+            names.push_back( named.name );
+        return names;
+    }();
+    return list;
+}
+
+void Colormap :: toRGBA( const double* values, size_t size, const ColorScaling& scaling, uint8_t* rgba ) const
+{
+    const size_t    last        =   this->size() - 1;
+    const uint32_t* lut         =   lut_.data();
+    const size_t    clear       =   this->size();
+
+    if( scaling.scale == ColorScale :: BREAKS )
+    {
+        const auto&     breaks  =   scaling.breaks;
+        const size_t    n       =   breaks.size();
+
+        for( size_t i = 0; i < size; i++ )
+        {
+            double v = values[ i ];
+
+            // branch-free count of thresholds at or below v, NaN counts none
+            size_t k = 0;
+            for( size_t b = 0; b < n; b++ )
+                k += v >= breaks[ b ];
+
+            size_t index = k == 0 ? clear : ( n == 1 ? last : ( ( k - 1 ) * last + ( n - 1 ) / 2 ) / ( n - 1 ) );
+            std :: memcpy( rgba + 4 * i, lut + index, 4 );
+        }
+        return;
+    }
+
+    const bool  logScale    =   scaling.scale == ColorScale :: LOG10;
+    double      lo          =   logScale ? std :: log10( scaling.lo ) : scaling.lo;
+    double      hi          =   logScale ? std :: log10( scaling.hi ) : scaling.hi;
+    double      scale       =   hi > lo ? static_cast<double>( last ) / ( hi - lo ) : 0.0;
+    size_t      i           =   0;
+
+#if defined( __AVX2__ )
+    const __m256d   vLo     =   _mm256_set1_pd( lo );
+    const __m256d   vScale  =   _mm256_set1_pd( scale );
+    const __m256d   vZero   =   _mm256_setzero_pd();
+    const __m256d   vLast   =   _mm256_set1_pd( static_cast<double>( last ) );
+    const __m256d   vClear  =   _mm256_set1_pd( static_cast<double>( clear ) );
+
+    for( ; i + 4 <= size; i += 4 )
+    {
+        __m256d v       =   _mm256_loadu_pd( values + i );
+        __m256d valid   =   _mm256_cmp_pd( v, v, _CMP_ORD_Q );
+
+        if( logScale )
+        {
+            valid   =   _mm256_and_pd( valid, _mm256_cmp_pd( v, vZero, _CMP_GT_OQ ) );
+            v       =   fastLog10( _mm256_max_pd( v, _mm256_set1_pd( 1e-300 ) ) );
+        }
+
+        __m256d t   =   _mm256_mul_pd( _mm256_sub_pd( v, vLo ), vScale );
+        t           =   _mm256_min_pd( _mm256_max_pd( t, vZero ), vLast );
+        t           =   _mm256_blendv_pd( vClear, t, valid );
+
+        __m128i index   =   _mm256_cvtpd_epi32( t );
+        __m128i colors  =   _mm_i32gather_epi32( reinterpret_cast<const int*>( lut ), index, 4 );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( rgba + 4 * i ), colors );
+    }
+#elif defined( COLORMAP_NEON )
+    const float64x2_t   vLo     =   vdupq_n_f64( lo );
+    const float64x2_t   vScale  =   vdupq_n_f64( scale );
+    const float64x2_t   vZero   =   vdupq_n_f64( 0.0 );
+    const float64x2_t   vLast   =   vdupq_n_f64( static_cast<double>( last ) );
+    const float64x2_t   vClear  =   vdupq_n_f64( static_cast<double>( clear ) );
+
+    for( ; i + 2 <= size; i += 2 )
+    {
+        float64x2_t v       =   vld1q_f64( values + i );
+        uint64x2_t  valid   =   vceqq_f64( v, v );
+
+        if( logScale )
+        {
+            valid   =   vandq_u64( valid, vcgtq_f64( v, vZero ) );
+            v       =   fastLog10( vmaxq_f64( v, vdupq_n_f64( 1e-300 ) ) );
+        }
+
+        float64x2_t t   =   vmulq_f64( vsubq_f64( v, vLo ), vScale );
+        t               =   vminq_f64( vmaxq_f64( t, vZero ), vLast );
+        t               =   vbslq_f64( valid, t, vClear );
+
+        int64x2_t index =   vcvtnq_s64_f64( t );
+        std :: memcpy( rgba + 4 * i,       lut + vgetq_lane_s64( index, 0 ), 4 );
+        std :: memcpy( rgba + 4 * i + 4,   lut + vgetq_lane_s64( index, 1 ), 4 );
+    }
+#endif
+
+    for( ; i < size; i++ )
+    {
+        double  v       =   values[ i ];
+        bool    valid   =   v == v && ( !logScale || v > 0.0 );
+        size_t  index   =   clear;
+
+        if( valid )
+        {
+            if( logScale )
+                v = fastLog10( std :: max( v, 1e-300 ) );
+
+            double t = std :: min( std :: max( ( v - lo ) * scale, 0.0 ), static_cast<double>( last ) );
+            index = static_cast<size_t>( std :: nearbyint( t ) );
+        }
+        std :: memcpy( rgba + 4 * i, lut + index, 4 );
+    }
+}
+
+void Colormap :: toPaletteIndices( const uint8_t* rgba, size_t size, uint8_t* indices ) const
+{
+    // runs of one color are the common case, only look up when the color changes
+    uint32_t    previous    =   lut_.back();
+    uint8_t     index       =   0;
+
+    for( size_t i = 0; i < size; i++ )
+    {
+        uint32_t color;
+        std :: memcpy( &color, rgba + i * 4, sizeof( color ) );
+
+        if( color != previous )
+        {
+            auto it     =   paletteIndex_.find( color );
+            index       =   it == paletteIndex_.end() ? 0 : it->second;
+            previous    =   color;
+        }
+        indices[ i ] = index;
+    }
+}
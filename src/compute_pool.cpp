@@ -0,0 +1,144 @@
+#include "compute_pool.h"
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+
+ComputePool :: ComputePool( size_t threads, const std :: vector<Class>& classes )
+{
+    if( threads == 0 )
+        threads = std :: thread :: hardware_concurrency() > 0 ? std :: thread :: hardware_concurrency() : 4;
+
+    for( const Class& limits : classes )
+    {
+        Queue queue;
+        queue.limits                =   limits;
+        queue.limits.concurrency    =   limits.concurrency == 0 ? threads : std :: min( limits.concurrency, threads );
+        queues_.push_back( std :: move( queue ) );
+    }
+
+    for( size_t i = 0; i < threads; i++ )
+        threads_.emplace_back( [ this ] { work(); } );
+}
+
+ComputePool :: ~ComputePool()
+{
+    {
+        std :: lock_guard<std :: mutex> lock( mutex_ );
+        stop_ = true;
+    }
+    wake_.notify_all();
+
+    for( auto& thread : threads_ )
+        thread.join();
+}
+
+bool ComputePool :: trySubmit( size_t priority, Task task )
+{
+    {
+        std :: lock_guard<std :: mutex> lock( mutex_ );
+
+        Queue& queue = queues_[ priority ];
+        if( queue.tasks.size() >= queue.limits.capacity )
+            return false;
+
+        queue.tasks.push_back( std :: move( task ) );
+    }
+    wake_.notify_one();
+    return true;
+}
+
+bool ComputePool :: trySubmitHelper( size_t priority, Task task )
+{
+    {
+        std :: lock_guard<std :: mutex> lock( mutex_ );
+
+        Queue& queue = queues_[ priority ];
+        if( queue.helpers.size() >= threads_.size() )
+            return false;
+
+        queue.helpers.push_back( std :: move( task ) );
+    }
+    wake_.notify_one();
+    return true;
+}
+
+size_t ComputePool :: queued( size_t priority ) const
+{
+    std :: lock_guard<std :: mutex> lock( mutex_ );
+    return queues_[ priority ].tasks.size();
+}
+
+size_t ComputePool :: running( size_t priority ) const
+{
+    std :: lock_guard<std :: mutex> lock( mutex_ );
+    return queues_[ priority ].running;
+}
+
+ComputePool :: Queue* ComputePool :: next()
+{
+    // running[ k ]: tasks running in class k and every less urgent class
+    std :: vector<size_t> running( queues_.size() + 1, 0 );
+    for( size_t k = queues_.size(); k-- > 0; )
+        running[ k ] = running[ k + 1 ] + queues_[ k ].running;
+
+    // a task of class i counts against the bound of every class up to i
+    for( size_t i = 0; i < queues_.size(); i++ )
+    {
+        if( queues_[ i ].tasks.empty() && queues_[ i ].helpers.empty() )
+            continue;
+
+        bool startable = true;
+        for( size_t k = 0; k <= i && startable; k++ )
+            startable = running[ k ] < queues_[ k ].limits.concurrency;
+
+        if( startable )
+            return &queues_[ i ];
+    }
+    return nullptr;
+}
+
+void ComputePool :: work()
+{
+    std :: unique_lock<std :: mutex> lock( mutex_ );
+    while( true )
+    {
+        Queue* queue = nullptr;
+        wake_.wait( lock, [ & ] { return stop_ || ( queue = next() ) != nullptr; } );
+        if( stop_ )
+            return;
+
+        // helpers first, they finish work already admitted
+        std :: deque<Task>& tasks = queue->helpers.empty() ? queue->tasks : queue->helpers;
+
+        Task task = std :: move( tasks.front() );
+        tasks.pop_front();
+        queue->running++;
+
+        current_            =   this;
+        currentPriority_    =   queue - queues_.data();
+
+        lock.unlock();
+        try
+        {
+            task();
+        }
+        catch( const std :: exception& e )
+        {
+            std :: cerr << "ComputePool :: work: task failed: " << e.what() << std :: endl;
+        }
+        catch( ... )
+        {
+            std :: cerr << "ComputePool :: work: task failed" << std :: endl;
+        }
+        task = nullptr;
+        lock.lock();
+
+        current_ = nullptr;
+
+        queue->running--;
+
+        // a task of a class that was at its bound may be startable now
+        wake_.notify_one();
+    }
+}
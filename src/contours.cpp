@@ -0,0 +1,217 @@
+#include "contours.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+
+namespace
+{
+    // value of the synthetic border around the plane
+    constexpr double kBorder = -std :: numeric_limits<double> :: infinity();
+
+    // signed area, positive for counter-clockwise rings
+    double signedArea( const Ring& ring )
+    {
+        double area = 0.0;
+        for( size_t i = 0; i + 1 < ring.size(); i++ )
+            area += ring[ i ][ 0 ] * ring[ i + 1 ][ 1 ] - ring[ i + 1 ][ 0 ] * ring[ i ][ 1 ];
+        return 0.5 * area;
+    }
+
+    // even-odd ray cast
+    bool contains( const Ring& ring, const Point& p )
+    {
+        bool inside = false;
+        for( size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++ )
+        {
+            const Point& a = ring[ i ];
+            const Point& b = ring[ j ];
+            if( ( a[ 1 ] > p[ 1 ] ) != ( b[ 1 ] > p[ 1 ] ) && 
+                p[ 0 ] < ( b[ 0 ] - a[ 0 ] ) * ( p[ 1 ] - a[ 1 ] ) / ( b[ 1 ] - a[ 1 ] ) + a[ 0 ] )
+                inside = !inside;
+        }
+        return inside;
+    }
+}
+
+/*!
+    Each cell is walked counter-clockwise ( c0 bottom-left, c1 bottom-right, c2 top-right, 
+    c3 top-left; edge k runs from ck to ck+1 ). An edge going above -> below is an exit, 
+    below -> above an entry, and each segment runs exit -> entry so the region above the 
+    level stays on its left. Saddles pair an exit with the next entry when the cell center 
+    is above, the previous one otherwise. A crossing is an exit in exactly one of the two 
+    cells sharing its edge, so segments chain by edge id into closed, oriented rings.
+*/
+std :: vector<Polygon> contourPolygons( const double* values, 
+                                        const std :: vector<double>& x, 
+                                        const std :: vector<double>& y, 
+                                        double level )
+{
+    size_t nx = x.size();
+    size_t ny = y.size();
+
+    if( nx == 0 || ny == 0 )
+        return {};
+
+    // pad by one node on each side, the border nodes reuse the edge coordinates
+    size_t px = nx + 2;
+    size_t py = ny + 2;
+
+    std :: vector<double> grid( px * py, kBorder );
+    std :: vector<double> gx( px );
+    std :: vector<double> gy( py );
+
+    for( size_t i = 0; i < ny; i++ )
+    {
+        for( size_t j = 0; j < nx; j++ )
+        {
+            double v = values[ i * nx + j ];
+            grid[ ( i + 1 ) * px + j + 1 ] = std :: isnan( v ) ? kBorder : v;
+        }
+    }
+    for( size_t j = 0; j < px; j++ ) gx[ j ] = x[ std :: clamp<size_t>( j, 1, nx ) - 1 ];
+    for( size_t i = 0; i < py; i++ ) gy[ i ] = y[ std :: clamp<size_t>( i, 1, ny ) - 1 ];
+
+    // horizontal edge ( i, j ) - ( i, j + 1 ) and vertical edge ( i, j ) - ( i + 1, j )
+    size_t verticalBase = px * py;
+    auto horizontal = [ & ]( size_t i, size_t j ) -> uint64_t { return i * px + j; };
+    auto vertical   = [ & ]( size_t i, size_t j ) -> uint64_t { return verticalBase + i * px + j; };
+
+    // crossing on an edge, always interpolated from its lower-left node
+    auto crossing = [ & ]( uint64_t edge ) -> Point
+    {
+        bool    isVertical  =   edge >= verticalBase;
+        size_t  node        =   isVertical ? edge - verticalBase : edge;
+        size_t  i           =   node / px;
+        size_t  j           =   node % px;
+        size_t  i2          =   isVertical ? i + 1 : i;
+        size_t  j2          =   isVertical ? j : j + 1;
+
+        double  va          =   grid[ i * px + j ];
+        double  vb          =   grid[ i2 * px + j2 ];
+
+        // crossings next to the border sit on the real node
+        double  t           =   va == kBorder ? 1.0 : vb == kBorder ? 0.0 : ( level - va ) / ( vb - va );
+
+        return { gx[ j ] + t * ( gx[ j2 ] - gx[ j ] ), gy[ i ] + t * ( gy[ i2 ] - gy[ i ] ) };
+    };
+
+    // directed segments, start edge -> end edge
+    std :: unordered_map<uint64_t, uint64_t> next;
+
+    for( size_t i = 0; i + 1 < py; i++ )
+    {
+        for( size_t j = 0; j + 1 < px; j++ )
+        {
+            double corner[ 4 ] = 
+            {
+                grid[ i * px + j ], grid[ i * px + j + 1 ], grid[ ( i + 1 ) * px + j + 1 ], grid[ ( i + 1 ) * px + j ]
+            };
+            uint64_t edge[ 4 ] = 
+            {
+                horizontal( i, j ), vertical( i, j + 1 ), horizontal( i + 1, j ), vertical( i, j )
+            };
+
+            bool above[ 4 ];
+            int  count = 0;
+            for( int k = 0; k < 4; k++ )
+            {
+                above[ k ] = corner[ k ] >= level;
+                count += above[ k ];
+            }
+            if( count == 0 || count == 4 )
+                continue;
+
+            int exits[ 2 ];
+            int entries[ 2 ];
+            int exitCount   =   0;
+            int entryCount  =   0;
+            for( int k = 0; k < 4; k++ )
+            {
+                if( above[ k ] && !above[ ( k + 1 ) % 4 ] ) exits[ exitCount++ ] = k;
+                if( !above[ k ] && above[ ( k + 1 ) % 4 ] ) entries[ entryCount++ ] = k;
+            }
+
+            if( exitCount == 1 )
+            {
+                next[ edge[ exits[ 0 ] ] ] = edge[ entries[ 0 ] ];
+                continue;
+            }
+
+            // saddle, only interior cells can get here so the corners are finite
+            bool centerAbove = 0.25 * ( corner[ 0 ] + corner[ 1 ] + corner[ 2 ] + corner[ 3 ] ) >= level;
+            for( int e = 0; e < 2; e++ )
+            {
+                int k = centerAbove ? ( exits[ e ] + 1 ) % 4 : ( exits[ e ] + 3 ) % 4;
+                next[ edge[ exits[ e ] ] ] = edge[ k ];
+            }
+        }
+    }
+
+    // chain segments into rings
+    std :: vector<Ring> outers;
+    std :: vector<Ring> holes;
+
+    while( !next.empty() )
+    {
+        uint64_t    start   =   next.begin()->first;
+        uint64_t    edge    =   start;
+        Ring        ring;
+
+        do
+        {
+            Point p = crossing( edge );
+            if( ring.empty() || ring.back() != p )
+                ring.push_back( p );
+
+            auto it = next.find( edge );
+            edge = it->second;
+            next.erase( it );
+        }
+        while( edge != start && next.count( edge ) );
+
+        if( ring.size() > 1 && ring.front() == ring.back() )
+            ring.pop_back();
+        if( ring.size() < 3 )
+            continue;
+        ring.push_back( ring.front() );
+
+        // a decreasing axis mirrors the plane and flips orientation
+        double area = signedArea( ring );
+        if( ( x.back() < x.front() ) != ( y.back() < y.front() ) )
+        {
+            area = -area;
+            std :: reverse( ring.begin(), ring.end() );
+        }
+
+        if( area > 0.0 )
+            outers.push_back( std :: move( ring ) );
+        else if( area < 0.0 )
+            holes.push_back( std :: move( ring ) );
+    }
+
+    std :: vector<Polygon> polygons;
+    std :: vector<double>  areas;
+    for( auto& outer : outers )
+    {
+        areas.push_back( signedArea( outer ) );
+        polygons.push_back( Polygon{ std :: move( outer ) } );
+    }
+
+    // each hole belongs to the smallest exterior that contains it
+    for( auto& hole : holes )
+    {
+        size_t best = polygons.size();
+        for( size_t p = 0; p < polygons.size(); p++ )
+        {
+            if( contains( polygons[ p ][ 0 ], hole[ 0 ] ) && ( best == polygons.size() || std :: abs( areas[ p ] ) < std :: abs( areas[ best ] ) ) )
+                best = p;
+        }
+        if( best < polygons.size() )
+            polygons[ best ].push_back( std :: move( hole ) );
+    }
+
+    return polygons;
+}
@@ -0,0 +1,192 @@
+#include "gif_encoder.h"
+#include "parallel.h"
+
+#include <stdexcept>
+
+namespace
+{
+    void put16( std :: string& out, uint16_t value )
+    {
+        out += static_cast<char>( value & 0xff );
+        out += static_cast<char>( value >> 8 );
+    }
+
+    // LSB first bit packer emitting 255 byte sub-blocks
+    class BlockWriter
+    {
+        public:
+            explicit BlockWriter( std :: string& out ) : out_( out ) {}
+
+            void code( uint32_t code, uint32_t bits )
+            {
+                accumulator_    |=  code << used_;
+                used_           +=  bits;
+
+                while( used_ >= 8 )
+                {
+                    byte( static_cast<char>( accumulator_ & 0xff ) );
+                    accumulator_    >>= 8;
+                    used_           -=  8;
+                }
+            }
+
+            void finish()
+            {
+                if( used_ > 0 )
+                    byte( static_cast<char>( accumulator_ & 0xff ) );
+                if( !block_.empty() )
+                    flush();
+                out_ += '\0';
+            }
+
+        private:
+            void byte( char value )
+            {
+                block_ += value;
+                if( block_.size() == 255 )
+                    flush();
+            }
+
+            void flush()
+            {
+                out_ += static_cast<char>( block_.size() );
+                out_ += block_;
+                block_.clear();
+            }
+
+            std :: string&  out_;
+            std :: string   block_;
+            uint32_t        accumulator_    =   0;
+            uint32_t        used_           =   0;
+    };
+
+    /*!
+        Image data for one frame: minimum code size 8, then LZW codes. The dictionary is a 
+        4096 x 256 child table ( code, next index ) -> code, cleared whenever the 12 bit 
+        code space fills up.
+    */
+    std :: string compressFrame( const uint8_t* pixels, size_t count )
+    {
+        constexpr uint32_t kMinCodeSize =   8;
+        constexpr uint32_t kClear       =   1u << kMinCodeSize;
+        constexpr uint32_t kMaxCode     =   4095;
+
+        std :: string   out( 1, static_cast<char>( kMinCodeSize ) );
+        BlockWriter     writer( out );
+
+        std :: vector<uint16_t> children( size_t( 4096 ) * 256, 0 );
+
+        uint32_t codeSize   =   kMinCodeSize + 1;
+        uint32_t maxCode    =   kClear + 1;
+
+        writer.code( kClear, codeSize );
+
+        uint32_t current = pixels[ 0 ];
+        for( size_t i = 1; i < count; i++ )
+        {
+            uint8_t     next    =   pixels[ i ];
+            uint16_t&   child   =   children[ size_t( current ) * 256 + next ];
+
+            if( child != 0 )
+            {
+                current = child;
+                continue;
+            }
+
+            writer.code( current, codeSize );
+            child = static_cast<uint16_t>( ++maxCode );
+
+            if( maxCode >= ( 1u << codeSize ) )
+                codeSize++;
+
+            if( maxCode == kMaxCode )
+            {
+                writer.code( kClear, codeSize );
+                std :: fill( children.begin(), children.end(), 0 );
+                codeSize    =   kMinCodeSize + 1;
+                maxCode     =   kClear + 1;
+            }
+            current = next;
+        }
+
+        writer.code( current, codeSize );
+
+        // the decoder adds an entry for that last code too, and widens when it fills the width
+        if( maxCode + 1 >= ( 1u << codeSize ) && codeSize < 12 )
+            codeSize++;
+
+        writer.code( kClear, codeSize );
+        writer.code( kClear + 1, kMinCodeSize + 1 );
+        writer.finish();
+        return out;
+    }
+}
+
+std :: string encodeGIF( const std :: vector<const uint8_t*>& frames,
+                         uint16_t width,
+                         uint16_t height,
+                         const std :: vector<uint32_t>& palette,
+                         int transparent,
+                         uint16_t delayCs )
+{
+    if( frames.empty() || width == 0 || height == 0 || palette.empty() || palette.size() > 256 )
+        throw std :: invalid_argument( "encodeGIF: need frames, a non-empty image and 1 to 256 colors" );
+
+    size_t pixels = size_t( width ) * height;
+
+    std :: vector<std :: string> compressed( frames.size() );
+    parallelFor( frames.size(), [ & ]( size_t i )
+    {
+        compressed[ i ] = compressFrame( frames[ i ], pixels );
+    } );
+
+    // the color table is always 256 entries, unused ones black
+    std :: string gif = "GIF89a";
+    put16( gif, width );
+    put16( gif, height );
+    gif += static_cast<char>( 0xf7 );   // global table, 8 bit color resolution, 2^( 7 + 1 ) entries
+    gif += '\0';                        // background index
+    gif += '\0';                        // square pixels
+
+    for( size_t i = 0; i < 256; i++ )
+    {
+        uint32_t rgb = i < palette.size() ? palette[ i ] : 0;
+        gif += static_cast<char>( rgb & 0xff );
+        gif += static_cast<char>( ( rgb >> 8 ) & 0xff );
+        gif += static_cast<char>( ( rgb >> 16 ) & 0xff );
+    }
+
+    // NETSCAPE2.0 application extension, loop count 0 = forever
+    gif += "\x21\xff\x0b";
+    gif += "NETSCAPE2.0";
+    gif += "\x03\x01";
+    put16( gif, 0 );
+    gif += '\0';
+
+    bool hasTransparent = transparent >= 0 && transparent < 256;
+
+    for( auto& frame : compressed )
+    {
+        // graphic control: restore to background before the next frame, so transparent 
+        // pixels never show the previous one through
+        gif += "\x21\xf9\x04";
+        gif += static_cast<char>( ( 2 << 2 ) | ( hasTransparent ? 1 : 0 ) );
+        put16( gif, delayCs );
+        gif += static_cast<char>( hasTransparent ? transparent : 0 );
+        gif += '\0';
+
+        // image descriptor, full canvas, no local table
+        gif += '\x2c';
+        put16( gif, 0 );
+        put16( gif, 0 );
+        put16( gif, width );
+        put16( gif, height );
+        gif += '\0';
+
+        gif += frame;
+        std :: string().swap( frame );
+    }
+
+    gif += '\x3b';
+    return gif;
+}
@@ -0,0 +1,85 @@
+#include "jpeg_encoder.h"
+
+#include <csetjmp>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+#include <jpeglib.h>
+
+namespace
+{
+    // libjpeg reports fatal errors through a callback that must not return, jump back out
+    struct ErrorManager
+    {
+        jpeg_error_mgr  base;
+        std :: jmp_buf  jump;
+        char            message[ JMSG_LENGTH_MAX ];
+    };
+
+    void onError( j_common_ptr info )
+    {
+        auto* errors = reinterpret_cast<ErrorManager*>( info->err );
+        ( *info->err->format_message )( info, errors->message );
+        std :: longjmp( errors->jump, 1 );
+    }
+}
+
+std :: string encodeJPEG( const uint8_t* rgba, uint32_t width, uint32_t height, int quality, uint32_t background )
+{
+    if( width == 0 || height == 0 )
+        throw std :: invalid_argument( "encodeJPEG: empty image" );
+
+    jpeg_compress_struct    info{};
+    ErrorManager            errors{};
+    unsigned char*          buffer  =   nullptr;
+    unsigned long           size    =   0;
+
+    // only trivially destructible locals between here and the last libjpeg call, longjmp skips destructors
+    std :: vector<uint8_t>  row( size_t( width ) * 3 );
+
+    info.err                =   jpeg_std_error( &errors.base );
+    errors.base.error_exit  =   onError;
+
+    if( setjmp( errors.jump ) )
+    {
+        jpeg_destroy_compress( &info );
+        std :: free( buffer );
+        throw std :: runtime_error( std :: string( "encodeJPEG: " ) + errors.message );
+    }
+
+    jpeg_create_compress( &info );
+    jpeg_mem_dest( &info, &buffer, &size );
+
+    info.image_width        =   width;
+    info.image_height       =   height;
+    info.input_components   =   3;
+    info.in_color_space     =   JCS_RGB;
+
+    jpeg_set_defaults( &info );
+    jpeg_set_quality( &info, quality, TRUE );
+    jpeg_start_compress( &info, TRUE );
+
+    const int backgroundRGB[ 3 ] = { int( background >> 16 ) & 0xff, int( background >> 8 ) & 0xff, int( background ) & 0xff };
+
+    while( info.next_scanline < height )
+    {
+        const uint8_t* pixel = rgba + size_t( info.next_scanline ) * width * 4;
+        for( uint32_t x = 0; x < width; x++, pixel += 4 )
+        {
+            int alpha = pixel[ 3 ];
+            for( int c = 0; c < 3; c++ )
+                row[ x * 3 + c ] = static_cast<uint8_t>( ( pixel[ c ] * alpha + backgroundRGB[ c ] * ( 255 - alpha ) + 127 ) / 255 );
+        }
+
+        JSAMPROW rows[ 1 ] = { row.data() };
+        jpeg_write_scanlines( &info, rows, 1 );
+    }
+
+    jpeg_finish_compress( &info );
+    jpeg_destroy_compress( &info );
+
+    std :: string jpeg( reinterpret_cast<const char*>( buffer ), size );
+    std :: free( buffer );
+    return jpeg;
+}
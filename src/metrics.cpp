@@ -0,0 +1,326 @@
+#include "metrics.h"
+
+#include <array>
+#include <atomic>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+    // two sub-buckets per power of two microseconds, [ 2^e, 1.5 * 2^e ) and [ 1.5 * 2^e, 2^e+1 ), up to ~67 s
+    constexpr size_t kMaxExponent   =   26;
+    constexpr size_t kBuckets       =   kMaxExponent * 2;
+
+    // status classes 1xx .. 5xx
+    constexpr size_t kStatusClasses =   5;
+
+    using Counter = std :: atomic<uint64_t>;
+
+    // single writer, so a relaxed load + store is enough and avoids a locked add
+    inline void bump( Counter& counter, uint64_t amount = 1 )
+    {
+        counter.store( counter.load( std :: memory_order_relaxed ) + amount, std :: memory_order_relaxed );
+    }
+
+    struct Histogram
+    {
+        std :: array<Counter, kBuckets> buckets{};
+        Counter                         count{ 0 };
+        Counter                         sum{ 0 };
+    };
+
+    struct Shard
+    {
+        std :: array<std :: array<Histogram, Metrics :: PHASE_COUNT>, Metrics :: MAX_ROUTES>  phases;
+        std :: array<std :: array<Counter, kStatusClasses>, Metrics :: MAX_ROUTES>           requests{};
+        std :: array<Counter, Metrics :: MAX_ROUTES>                                          coalesced{};
+        std :: array<Counter, Metrics :: MAX_ROUTES>                                          shed{};
+        std :: array<Counter, Metrics :: MAX_ROUTES>                                          cancelled{};
+    };
+
+    struct Registry
+    {
+        std :: mutex                            mutex;
+        std :: vector<std :: unique_ptr<Shard>> shards;
+        std :: vector<std :: string>            routes;
+    };
+
+    Registry& registry()
+    {
+        static Registry instance;
+        return instance;
+    }
+
+    thread_local Shard* localShard      =   nullptr;
+    thread_local size_t currentRoute    =   Metrics :: MAX_ROUTES;
+
+    // per phase totals of the thread's current request, for Server-Timing
+    thread_local std :: array<uint64_t, Metrics :: PHASE_COUNT> requestPhases{};
+    thread_local std :: array<bool, Metrics :: PHASE_COUNT>     requestPhaseSeen{};
+
+    // shards live until exit, a scrape may still read one after its thread ended
+    Shard& shard()
+    {
+        if( !localShard )
+        {
+            auto& reg = registry();
+            std :: lock_guard<std :: mutex> lock( reg.mutex );
+            reg.shards.push_back( std :: make_unique<Shard>() );
+            localShard = reg.shards.back().get();
+        }
+        return *localShard;
+    }
+
+    size_t bucketFor( uint64_t micros )
+    {
+        if( micros < 2 )
+            return 0;
+
+        size_t exponent = 63 - __builtin_clzll( micros );
+        size_t upper    = ( micros >> ( exponent - 1 ) ) & 1;
+
+        // past the last bound, only shows up in +Inf
+        return exponent * 2 + upper;
+    }
+
+    // inclusive upper bound of a bucket, in seconds
+    double bucketBound( size_t bucket )
+    {
+        double base = static_cast<double>( uint64_t( 1 ) << ( bucket / 2 ) );
+        return ( bucket % 2 ? 2.0 * base : 1.5 * base ) * 1e-6;
+    }
+}
+
+size_t Metrics :: registerRoute( const std :: string& route )
+{
+    auto& reg = registry();
+    std :: lock_guard<std :: mutex> lock( reg.mutex );
+
+    for( size_t i = 0; i < reg.routes.size(); i++ )
+    {
+        if( reg.routes[ i ] == route )
+            return i;
+    }
+
+    if( reg.routes.size() >= MAX_ROUTES )
+        throw std :: length_error( "Metrics :: registerRoute: too many routes" );
+
+    reg.routes.push_back( route );
+    return reg.routes.size() - 1;
+}
+
+void Metrics :: beginRequest( size_t route )
+{
+    currentRoute = route;
+    requestPhases.fill( 0 );
+    requestPhaseSeen.fill( false );
+}
+
+void Metrics :: recordPhase( Phase phase, uint64_t micros )
+{
+    if( currentRoute >= MAX_ROUTES )
+        return;
+
+    Histogram&  histogram   =   shard().phases[ currentRoute ][ phase ];
+    size_t      bucket      =   bucketFor( micros );
+
+    if( bucket < kBuckets )
+        bump( histogram.buckets[ bucket ] );
+    bump( histogram.count );
+    bump( histogram.sum, micros );
+
+    requestPhases[ phase ]      +=  micros;
+    requestPhaseSeen[ phase ]   =   true;
+}
+
+// e.g. validate;dur=0.012, read;dur=1.305, total;dur=1.9 ( milliseconds )
+std :: string Metrics :: serverTiming()
+{
+    std :: ostringstream out;
+    out << std :: fixed << std :: setprecision( 3 );
+
+    for( size_t p = 0; p < PHASE_COUNT; p++ )
+    {
+        if( !requestPhaseSeen[ p ] )
+            continue;
+
+        if( out.tellp() > 0 )
+            out << ", ";
+        out << phaseName( Phase( p ) ) << ";dur=" << requestPhases[ p ] * 1e-3;
+    }
+    return out.str();
+}
+
+void Metrics :: endRequest( int statusCode, uint64_t micros )
+{
+    if( currentRoute >= MAX_ROUTES )
+        return;
+
+    recordPhase( TOTAL, micros );
+
+    size_t statusClass = std :: min<size_t>( kStatusClasses, std :: max( 1, statusCode / 100 ) ) - 1;
+    bump( shard().requests[ currentRoute ][ statusClass ] );
+
+    currentRoute = MAX_ROUTES;
+}
+
+size_t Metrics :: requestRoute()
+{
+    return currentRoute;
+}
+
+Metrics :: RouteScope :: RouteScope( size_t route ) : previous_( currentRoute )
+{
+    currentRoute = route;
+}
+
+Metrics :: RouteScope :: ~RouteScope()
+{
+    currentRoute = previous_;
+}
+
+void Metrics :: recordCoalesced()
+{
+    if( currentRoute >= MAX_ROUTES )
+        return;
+
+    bump( shard().coalesced[ currentRoute ] );
+}
+
+void Metrics :: recordShed()
+{
+    if( currentRoute >= MAX_ROUTES )
+        return;
+
+    bump( shard().shed[ currentRoute ] );
+}
+
+void Metrics :: recordCancelled()
+{
+    if( currentRoute >= MAX_ROUTES )
+        return;
+
+    bump( shard().cancelled[ currentRoute ] );
+}
+
+const char* Metrics :: phaseName( Phase phase )
+{
+    static const char* names[ PHASE_COUNT ] = 
+    {
+        "validate", "read", "transform", "json", "serialize", "render", "encode", "queue", "total"
+    };
+    return names[ phase ];
+}
+
+/*!
+    Sum every shard under the registry lock ( only shard creation contends with it )
+    and write counters and cumulative histograms in the Prometheus text format.
+    Series that never recorded anything are left out.
+*/
+std :: string Metrics :: prometheus()
+{
+    auto& reg = registry();
+    std :: lock_guard<std :: mutex> lock( reg.mutex );
+
+    auto load = []( const Counter& counter ) { return counter.load( std :: memory_order_relaxed ); };
+
+    std :: ostringstream out;
+    out << std :: setprecision( 9 );
+
+    out << "# HELP netcdf_server_requests_total Requests served, by route and status class.\n"
+        << "# TYPE netcdf_server_requests_total counter\n";
+
+    for( size_t r = 0; r < reg.routes.size(); r++ )
+    {
+        for( size_t c = 0; c < kStatusClasses; c++ )
+        {
+            uint64_t total = 0;
+            for( const auto& s : reg.shards )
+                total += load( s->requests[ r ][ c ] );
+
+            if( total > 0 )
+                out << "netcdf_server_requests_total{route=\"" << reg.routes[ r ] << "\",code=\"" << c + 1 << "xx\"} " << total << '\n';
+        }
+    }
+
+    out << "# HELP netcdf_server_coalesced_requests_total Requests answered from another request's in-flight read, by route.\n"
+        << "# TYPE netcdf_server_coalesced_requests_total counter\n";
+
+    for( size_t r = 0; r < reg.routes.size(); r++ )
+    {
+        uint64_t total = 0;
+        for( const auto& s : reg.shards )
+            total += load( s->coalesced[ r ] );
+
+        if( total > 0 )
+            out << "netcdf_server_coalesced_requests_total{route=\"" << reg.routes[ r ] << "\"} " << total << '\n';
+    }
+
+    out << "# HELP netcdf_server_shed_requests_total Requests refused with 503 because the compute queue was full, by route.\n"
+        << "# TYPE netcdf_server_shed_requests_total counter\n";
+
+    for( size_t r = 0; r < reg.routes.size(); r++ )
+    {
+        uint64_t total = 0;
+        for( const auto& s : reg.shards )
+            total += load( s->shed[ r ] );
+
+        if( total > 0 )
+            out << "netcdf_server_shed_requests_total{route=\"" << reg.routes[ r ] << "\"} " << total << '\n';
+    }
+
+    out << "# HELP netcdf_server_cancelled_requests_total Requests abandoned past their deadline or after the client disconnected, by route.\n"
+        << "# TYPE netcdf_server_cancelled_requests_total counter\n";
+
+    for( size_t r = 0; r < reg.routes.size(); r++ )
+    {
+        uint64_t total = 0;
+        for( const auto& s : reg.shards )
+            total += load( s->cancelled[ r ] );
+
+        if( total > 0 )
+            out << "netcdf_server_cancelled_requests_total{route=\"" << reg.routes[ r ] << "\"} " << total << '\n';
+    }
+
+    out << "# HELP netcdf_server_phase_duration_seconds Time spent per request phase, by route.\n"
+        << "# TYPE netcdf_server_phase_duration_seconds histogram\n";
+
+    for( size_t r = 0; r < reg.routes.size(); r++ )
+    {
+        for( size_t p = 0; p < PHASE_COUNT; p++ )
+        {
+            std :: array<uint64_t, kBuckets>    buckets{};
+            uint64_t                            count   =   0;
+            uint64_t                            sum     =   0;
+
+            for( const auto& s : reg.shards )
+            {
+                const Histogram& h = s->phases[ r ][ p ];
+                for( size_t b = 0; b < kBuckets; b++ )
+                    buckets[ b ] += load( h.buckets[ b ] );
+                count   +=  load( h.count );
+                sum     +=  load( h.sum );
+            }
+
+            if( count == 0 )
+                continue;
+
+            std :: string labels = "route=\"" + reg.routes[ r ] + "\",phase=\"" + phaseName( Phase( p ) ) + "\"";
+
+            uint64_t cumulative = 0;
+            for( size_t b = 0; b < kBuckets; b++ )
+            {
+                cumulative += buckets[ b ];
+                out << "netcdf_server_phase_duration_seconds_bucket{" << labels << ",le=\"" << bucketBound( b ) << "\"} " << cumulative << '\n';
+            }
+            out << "netcdf_server_phase_duration_seconds_bucket{" << labels << ",le=\"+Inf\"} " << count << '\n'
+                << "netcdf_server_phase_duration_seconds_sum{" << labels << "} " << sum * 1e-6 << '\n'
+                << "netcdf_server_phase_duration_seconds_count{" << labels << "} " << count << '\n';
+        }
+    }
+
+    return out.str();
+}
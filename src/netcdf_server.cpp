@@ -1,4 +1,7 @@
 #include "netcdf_server.h"
+#include "parallel.h"
+
+#include <filesystem>
 
 // TO-DO: replace vector copying with move semantics - DONE
 // TO-DO: Clean up, thread safety, etc - DONE (mostly)
@@ -9,50 +12,245 @@
 thread_local uint NetCDFServer :: timeIndex_    =   0;
 thread_local uint NetCDFServer :: zIndex_       =   0;
 thread_local uint NetCDFServer :: responseCode_ =   200;
+thread_local std :: string NetCDFServer :: spooledPath_;
 
 thread_local std :: vector<double> NetCDFServer :: concentrationData_;
 
 NetCDFServer :: NetCDFServer( const std :: string& fileName ) : fileName_( fileName ), 
-                                                                dataFile_( fileName, NcFile :: read )
+                                                                dataFile_( std :: make_unique<NcFile>( fileName, NcFile :: read ) )
 {
     // force matplot++ to not open gnuplot
     setenv( "QT_QPA_PLATFORM", "offscreen", 1 );
+
+    loadCoordinates();
+    dataset_ = loadDatasetVersion( nullptr );
+
+    std :: filesystem :: create_directories( SPOOL_PATH );
+
+    size_t planeBytes = yCoords_.size() * xCoords_.size() * sizeof( double );
+    doseCache_ = std :: make_unique<ResultCache<uint64_t, std :: vector<double>>>( std :: max<size_t>( 2, DOSE_CACHE_BYTES / std :: max<size_t>( 1, planeBytes ) ) );
+
+    // the in-flight quota covers the requests the compute pool would not queue as cheap
+    setRateLimit( RATE_LIMIT_PER_S, RATE_LIMIT_BURST, MAX_CLIENT_IN_FLIGHT );
+    app_.get_middleware<RateLimiter>()
+        .apiKeyHeader( API_KEY_HEADER )
+        .trustedProxies( TRUSTED_PROXIES )
+        .expensive( [ this ]( const Request& request ) 
+        { 
+            return estimateCost( request, request.url == "/get-image" ? "Accept" : "" ) != Cost :: CHEAP; 
+        } );
+}
+
+NetCDFServer :: ~NetCDFServer()
+{
+    stopWatcher();
+
+    // workers post completions to the IO contexts, finish them while those still exist
+    computePool_.reset();
+}
+
+void NetCDFServer :: run( uint port, uint threads, uint computeThreads ) 
+{
+    computePool_ = std :: make_unique<ComputePool>( computeThreads, computeClasses( computeThreads ) );
+
+    registerRoutes();
+    startWatcher();
+
+    // start on localhost port 18080
+    //app_.bindaddr( "127.0.0.1" ).port( port ).multithreaded().run();  // for local build
+
+    app_.bindaddr( "0.0.0.0" ).port( port ).concurrency( ioThreads( threads ) ).run();      
+}
+
+// same as run() without blocking; port 0 binds an ephemeral port, see port()
+std :: future<void> NetCDFServer :: runAsync( uint port, uint threads, uint computeThreads )
+{
+    computePool_ = std :: make_unique<ComputePool>( computeThreads, computeClasses( computeThreads ) );
+
+    registerRoutes();
+    startWatcher();
+
+    app_.bindaddr( "127.0.0.1" ).port( port ).concurrency( ioThreads( threads ) );
+
+    auto done = app_.run_async();
+    app_.wait_for_server_start();
+    return done;
+}
+
+uint16_t NetCDFServer :: port() const
+{
+    return app_.port();
+}
+
+void NetCDFServer :: setRateLimit( double perSecond, double burst, uint maxInFlight )
+{
+    app_.get_middleware<RateLimiter>().rate( perSecond, burst ).maxInFlight( maxInFlight );
+}
+
+void NetCDFServer :: setTrustedProxies( const std :: vector<std :: string>& addresses )
+{
+    app_.get_middleware<RateLimiter>().trustedProxies( addresses );
 }
 
-void NetCDFServer :: run( uint port ) 
+void NetCDFServer :: setDeadline( const std :: string& route, uint deadlineMs )
 {
+    deadlinesMs_[ route ] = deadlineMs;
+}
+
+void NetCDFServer :: stop()
+{
+    stopWatcher();
+    app_.stop();
+}
+
+// 0 means a quarter of the hardware threads, the IO threads no longer run handlers
+uint NetCDFServer :: ioThreads( uint threads )
+{
+    if( threads > 0 )
+        return threads;
+    return std :: max( 2u, std :: thread :: hardware_concurrency() / 4 );
+}
+
+// queue sizes and concurrency bounds per Cost, in that order; 0 threads means one per hardware thread.
+// Moderate and expensive work together leave a worker for cheap work whenever there are two
+std :: vector<ComputePool :: Class> NetCDFServer :: computeClasses( uint threads )
+{
+    size_t workers = threads > 0 ? threads : std :: max( 1u, std :: thread :: hardware_concurrency() );
+
+    return { { CHEAP_QUEUE_SIZE,        workers },
+             { MODERATE_QUEUE_SIZE,     std :: max<size_t>( 1, std :: min( workers * 3 / 4, workers - 1 ) ) },
+             { EXPENSIVE_QUEUE_SIZE,    std :: max<size_t>( 1, workers / 2 ) } };
+}
+
+void NetCDFServer :: registerRoutes()
+{
+    // cheap, but a miss reads the file under ncMutex_, so it stays off the IO threads too
     CROW_ROUTE( app_, "/get-info" )
-    ( [ this ]( const Request& request ) 
+    ( [ this, route = Metrics :: registerRoute( "/get-info" ) ]( const Request& request, Response& response ) 
     {
-        auto query      { request.raw_url };
-
-        if( query.find( '?' ) != std :: string :: npos )
+        offload( route, request, response, CACHE_REVALIDATE, [ this, &request ]
         {
-            JSONValue result;
-            result[ "error" ] = Errors :: REMOVE_PARMS;
-            return JSONResponse( result, APPLICATION_JSON );
-        }
+            auto query      { request.raw_url };
+
+            if( query.find( '?' ) != std :: string :: npos )
+            {
+                JSONValue result;
+                responseCode_ = 400;
+                result[ "error" ] = Errors :: REMOVE_PARMS;
+                return JSONResponse( result, APPLICATION_JSON );
+            }
 
-        return handleGetInfo();
+            return handleGetInfo();
+        } );
     } );
 
     CROW_ROUTE( app_, "/get-data" )
-    ( [ this ]( const Request& request )
+    ( [ this, route = Metrics :: registerRoute( "/get-data" ) ]( const Request& request, Response& response ) 
     {
-        return handleGetData( request );
+        offload( route, request, response, CACHE_IMMUTABLE, [ this, &request ] { return handleGetData( request ); } );
     } );
 
     CROW_ROUTE( app_, "/get-image" )
-    ( [ this ]( const Request& request ) 
+    ( [ this, route = Metrics :: registerRoute( "/get-image" ) ]( const Request& request, Response& response ) 
     {
-        return handleGetImage( request );
+        offload( route, request, response, colorCacheControl( request ), [ this, &request ] { return handleGetImage( request ); }, "Accept" );
+    } );
+
+    CROW_ROUTE( app_, "/get-stats" )
+    ( [ this, route = Metrics :: registerRoute( "/get-stats" ) ]( const Request& request, Response& response ) 
+    {
+        offload( route, request, response, CACHE_IMMUTABLE, [ this, &request ] { return handleGetStats( request ); } );
+    } );
+
+    CROW_ROUTE( app_, "/get-dose" )
+    ( [ this, route = Metrics :: registerRoute( "/get-dose" ) ]( const Request& request, Response& response ) 
+    {
+        offload( route, request, response, CACHE_IMMUTABLE, [ this, &request ] { return handleGetDose( request ); } );
+    } );
+
+    CROW_ROUTE( app_, "/get-contours" )
+    ( [ this, route = Metrics :: registerRoute( "/get-contours" ) ]( const Request& request, Response& response ) 
+    {
+        offload( route, request, response, CACHE_IMMUTABLE, [ this, &request ] { return handleGetContours( request ); } );
+    } );
+
+    CROW_ROUTE( app_, "/get-exceedance" )
+    ( [ this, route = Metrics :: registerRoute( "/get-exceedance" ) ]( const Request& request, Response& response ) 
+    {
+        offload( route, request, response, CACHE_IMMUTABLE, [ this, &request ] { return handleGetExceedance( request ); } );
+    } );
+
+    CROW_ROUTE( app_, "/get-raw" )
+    ( [ this, route = Metrics :: registerRoute( "/get-raw" ) ]( const Request& request, Response& response ) 
+    {
+        offload( route, request, response, CACHE_IMMUTABLE, [ this, &request ] { return handleGetRaw( request ); } );
+    } );
+
+    CROW_ROUTE( app_, "/get-animation" )
+    ( [ this, route = Metrics :: registerRoute( "/get-animation" ) ]( const Request& request, Response& response ) 
+    {
+        offload( route, request, response, colorCacheControl( request ), [ this, &request ] { return handleGetAnimation( request ); } );
+    } );
+
+    // live feed of appended time steps, see publishNewTimeSteps
+    CROW_WEBSOCKET_ROUTE( app_, "/subscribe" )
+    .onaccept( [ this ]( const Request& request, void** userdata )
+    {
+        auto*       pending = new PendingSubscription();
+        JSONValue   result;
+
+        if( !parseSubscription( request, result, pending->first ) )
+            pending->second = result.dump();
+
+        *userdata = pending;
+        return true;
+    } )
+    .onopen( [ this ]( crow :: websocket :: connection& connection )
+    {
+        std :: unique_ptr<PendingSubscription> pending( static_cast<PendingSubscription*>( connection.userdata() ) );
+        connection.userdata( nullptr );
+
+        if( !pending->second.empty() )
+        {
+            connection.send_text( pending->second );
+            connection.close( "invalid subscription", crow :: websocket :: CloseStatusCode :: PolicyViolated );
+            return;
+        }
+
+        // acknowledge with the window actually served and the steps that already exist
+        const Subscription& subscription = pending->first;
+
+        JSONValue ack;
+        ack[ kZ ]           =   subscription.zIndex;
+        ack[ "x0" ]         =   subscription.region.x0;
+        ack[ "nx" ]         =   subscription.region.nx;
+        ack[ "y0" ]         =   subscription.region.y0;
+        ack[ "ny" ]         =   subscription.region.ny;
+        ack[ "format" ]     =   subscription.binary ? "raw" : "json";
+        ack[ "time_size" ]  =   publishedTimeSize_.load();
+        connection.send_text( ack.dump() );
+
+        std :: lock_guard<std :: mutex> lock( subscribersMutex_ );
+        subscribers_[ &connection ] = subscription;
+    } )
+    .onclose( [ this ]( crow :: websocket :: connection& connection, const std :: string&, uint16_t )
+    {
+        // never opened, the pending subscription is still attached
+        delete static_cast<PendingSubscription*>( connection.userdata() );
+        connection.userdata( nullptr );
+
+        std :: lock_guard<std :: mutex> lock( subscribersMutex_ );
+        subscribers_.erase( &connection );
+    } );
+
+    // prometheus scrape, not itself instrumented
+    CROW_ROUTE( app_, "/metrics" )
+    ( [ this ]() 
+    {
+        responseCode_ = 200;
+        return bodyResponse( Metrics :: prometheus(), TEXT_PROMETHEUS );
     } );
 
-    // start on localhost port 18080
-    //app_.bindaddr( "127.0.0.1" ).port( port ).multithreaded().run();  // for local build
-    
-    uint threads = std :: thread :: hardware_concurrency() > 0 ? std :: thread :: hardware_concurrency() : 4;
-    app_.bindaddr( "0.0.0.0" ).port( port ).concurrency( threads ).run();      
 }
 
 
@@ -72,6 +270,9 @@ Response NetCDFServer :: handleGetInfo()
     // response object
     Response response;
 
+    // the version the summaries come from, the cache is only written while it is current
+    auto data = dataset();
+
     // serve up cached info
     {
         std :: shared_lock lock( infoMetadataMutex_ );
@@ -81,20 +282,31 @@ Response NetCDFServer :: handleGetInfo()
 
     try 
     { 
-        /*---------------*
-        | get dimensions |
-        *---------------*/
-        extractDimensions( result );
-
-        /*--------------*
-        | get variables |
-        *--------------*/
-        extractVariables( result );
-
-        /*----------------------*
-        | get global attributes |
-        *----------------------*/
-        extractGlobalAttributes( result );
+        TIME_PHASE( Metrics :: READ );
+        {
+            // compute workers read the same handle meanwhile
+            std :: lock_guard<std :: mutex> lock( ncMutex_ );
+
+            /*---------------*
+            | get dimensions |
+            *---------------*/
+            extractDimensions( result );
+
+            /*--------------*
+            | get variables |
+            *--------------*/
+            extractVariables( result );
+
+            /*----------------------*
+            | get global attributes |
+            *----------------------*/
+            extractGlobalAttributes( result );
+        }
+
+        /*--------------------*
+        | get slice summaries |
+        *--------------------*/
+        extractSliceSummary( result, data->summaryIndex );
     } 
     catch( const std :: exception& e )  
     {
@@ -107,7 +319,7 @@ Response NetCDFServer :: handleGetInfo()
     // attempt cache write under unique_lock
     {
         std :: unique_lock lock( infoMetadataMutex_ );
-        if ( !infoMetadataCached_ ) 
+        if ( !infoMetadataCached_ && data == dataset() ) 
         {
             cachedInfoMetadata_ = std :: move( result ); // the =operator is deleted for crow :: json :: wvalue
             infoMetadataCached_ = true;
@@ -123,7 +335,7 @@ void NetCDFServer :: extractDimensions( JSONValue& result )
     JSONMap dimensions;
 
     // get dimensions from the top level location - the file itself
-    for( const auto& dim : dataFile_.getDims() )  
+    for( const auto& dim : dataFile_->getDims() )  
     {
         // dim is a NcDim key-value pair, store the name and get the size
         dimensions[ dim.first ] = dim.second.getSize();
@@ -137,7 +349,7 @@ void NetCDFServer :: extractVariables( JSONValue& result )
 {
     JSONMap variables;
 
-    for( const auto& var : dataFile_.getVars() )  
+    for( const auto& var : dataFile_->getVars() )  
     {
         JSONMap varInfo;
 
@@ -202,7 +414,7 @@ void NetCDFServer :: extractVariables( JSONValue& result )
 void NetCDFServer :: extractGlobalAttributes( JSONValue& result )
 {
     JSONMap globalAttributes;
-    for( const auto& attr : dataFile_.getAtts() )  
+    for( const auto& attr : dataFile_->getAtts() )  
     {
         std :: string value;
         switch( attr.second.getType().getId() )  
@@ -243,6 +455,46 @@ void NetCDFServer :: extractGlobalAttributes( JSONValue& result )
     result[ "global_attributes" ] = std :: move( globalAttributes );
 }
 
+// per ( time, z ) summaries from the index, plus each level's overall range
+void NetCDFServer :: extractSliceSummary( JSONValue& result, const SliceSummaryIndex& summaryIndex )
+{
+    JSONList slices;
+    JSONList levels;
+
+    for( size_t t = 0; t < summaryIndex.timeSize(); t++ )
+    {
+        for( size_t z = 0; z < summaryIndex.zSize(); z++ )
+        {
+            const auto& summary = summaryIndex.at( t, z );
+
+            JSONValue slice;
+            slice[ kTime ]      =   t;
+            slice[ kZ ]         =   z;
+            slice[ "min" ]      =   jsonNumber( summary.min );
+            slice[ "max" ]      =   jsonNumber( summary.max );
+            slice[ "mean" ]     =   jsonNumber( summary.mean );
+            slice[ "nonzero" ]  =   summary.nonzero;
+            slices.push_back( std :: move( slice ) );
+        }
+    }
+
+    for( size_t z = 0; z < summaryIndex.zSize(); z++ )
+    {
+        auto range = summaryIndex.range( z );
+
+        JSONValue level;
+        level[ kZ ]     =   z;
+        level[ "min" ]  =   jsonNumber( range.first );
+        level[ "max" ]  =   jsonNumber( range.second );
+        levels.push_back( std :: move( level ) );
+    }
+
+    JSONMap summary;
+    summary[ "slices" ] = std :: move( slices );
+    summary[ "levels" ] = std :: move( levels );
+    result[ "slice_summary" ] = std :: move( summary );
+}
+
 
 /*++++++++++++++++*
 |  handleGetData  |
@@ -256,15 +508,59 @@ Response NetCDFServer :: handleGetData( const Request& request )
 {
     JSONValue   result;
     Response    response;
+    uint        timeEnd;
 
     if( !validateRequestParameters( request, 
                                     result, 
                                     timeIndex_, 
-                                    zIndex_ ) )
+                                    zIndex_,
+                                    { "time_end" } ) )
+        return JSONResponse( result, APPLICATION_JSON );
+
+    if( !parseTimeEnd( request, result, timeIndex_, timeEnd ) )
         return JSONResponse( result, APPLICATION_JSON );
 
-    result      =   extractNetCDFSlice( timeIndex_, zIndex_ );
-    response    =   JSONResponse( result, APPLICATION_JSON );
+    // a time range is written out slice by slice rather than built as one JSON value
+    if( timeEnd > timeIndex_ )
+    {
+        try
+        {
+            // %.17g takes at most 24 characters, plus one separator or bracket per number and row
+            uint64_t plane      =   uint64_t( yCoords_.size() ) * ( xCoords_.size() + 1 );
+            uint64_t maxBytes   =   ( ( timeEnd - timeIndex_ + 1 ) * ( plane + 1 ) + xCoords_.size() + yCoords_.size() ) * 25 + 64;
+
+            return spooledResponse( JSON_EXT, maxBytes, [ &, timeIndex = timeIndex_, zIndex = zIndex_ ]( std :: ostream& out )
+            {
+                writeSeriesJSON( timeIndex, timeEnd, zIndex, out );
+            } );
+        }
+        catch( const std :: exception& e )
+        {
+            responseCode_ = 500;
+            result[ kError ] = Errors :: EXTRACT_NCDF + e.what();
+            return JSONResponse( result, APPLICATION_JSON );
+        }
+    }
+
+    // concurrent requests for the same slice wait on the first one and share its body
+    bool coalesced  =   false;
+    auto slice      =   dataFlight_.run( sliceKey( timeIndex_, zIndex_ ), [ this ]
+    {
+        JSONValue   sliceJSON   =   extractNetCDFSlice( timeIndex_, zIndex_ );
+        SliceBody   sliceBody;
+
+        sliceBody.code  =   sliceJSON.count( kError ) > 0 ? 500 : 200;
+
+        TIME_PHASE( Metrics :: SERIALIZE );
+        sliceBody.body  =   sliceJSON.dump( 3 );
+        return sliceBody;
+    }, coalesced );
+
+    if( coalesced )
+        Metrics :: recordCoalesced();
+
+    responseCode_   =   slice->code;
+    response        =   bodyResponse( slice->body, APPLICATION_JSON );
     
     return response;
 }
@@ -277,61 +573,179 @@ Response NetCDFServer :: handleGetData( const Request& request )
 /*!
     function for c. get-image -  params to include time index and z index, 
     returns png visualization of concentration.
+    Any of colormap, scale, breaks, vmin, vmax, lut, width, height or resample switches 
+    to the native renderer: the slice itself, north up, through a colormap lookup table 
+    ( see parseColorScaling ) and encoded in process, with no figure around it. It is one 
+    pixel per cell unless width and / or height ask for a size ( see parseImageSize ). 
+    Native images are PNG, JPEG or WebP by format= or else the Accept header ( see 
+    parseImageFormat ), with quality for the lossy ones, and cached per format.
 */
 Response NetCDFServer :: handleGetImage( const Request& request )
 {
-    JSONValue   result;
-    Response    response;
+    JSONValue       result;
+    Response        response;
+    const Colormap* colormap    =   nullptr;
+    ColorScaling    scaling;
+    size_t          width       =   0;
+    size_t          height      =   0;
+    ResampleFilter  filter      =   ResampleFilter :: BILINEAR;
+    ImageFormat     format      =   ImageFormat :: PNG;
+    int             quality     =   0;
+    std :: vector<double>   levels;
+
+    std :: vector<std :: string> nativeParameters = IMAGE_PARAMETERS;
+    nativeParameters.insert( nativeParameters.end(), IMAGE_FORMAT_PARAMETERS.begin(), IMAGE_FORMAT_PARAMETERS.end() );
 
     if( !validateRequestParameters( request,
                                     result,
                                     timeIndex_,
-                                    zIndex_ ) ) 
+                                    zIndex_,
+                                    nativeParameters ) ) 
+        return JSONResponse( result, APPLICATION_JSON );
+
+    bool native = std :: any_of( nativeParameters.begin(), 
+                                 nativeParameters.end(), 
+                                 [ & ]( const std :: string& key ) { return request.url_params.get( key ) != nullptr; } );
+
+    if( native && ( !parseColorScaling( request, result, zIndex_, colormap, scaling ) || 
+                    !parseImageSize( request, result, width, height, filter ) ||
+                    !parseImageFormat( request, result, format, quality, levels ) ) )
         return JSONResponse( result, APPLICATION_JSON );
 
-    // extract into conentrationData_
-    result = extractNetCDFSlice( timeIndex_, zIndex_ );
+    const std :: string& contentType =  format == ImageFormat :: JPEG ? IMAGE_JPEG : 
+                                        format == ImageFormat :: WEBP ? IMAGE_WEBP : 
+                                        format == ImageFormat :: SVG  ? IMAGE_SVG  : IMAGE_PNG;
 
-    if ( result.count( kError ) > 0 ) 
+    // the same query renders the same pixels, only the encoding differs per format
+    std :: string cacheKey;
+    if( native )
+    {
+        cacheKey = entityTag( request, "Accept" );
+        if( auto cached = imageCache_.find( cacheKey ) )
+            return bodyResponse( *cached, contentType );
+    }
+
+    // the raw plane is all the image needs, shared with identical concurrent requests
+    std :: shared_ptr<const std :: vector<double>> slice;
+    try
+    {
+        slice = readSlice( timeIndex_, zIndex_ );
+    }
+    catch( const std :: exception& e )
     {
         responseCode_ = 500;
+        result[ kError ] = Errors :: EXTRACT_NCDF + e.what();
         return JSONResponse( result, APPLICATION_JSON );
     }
 
+    // the read may have waited on the NetCDF lock, do not render for a request given up on
+    CancelToken :: checkCurrent();
+
     // get into 2D array
-    auto xSize = result[ kX ].size();
-    auto ySize = result[ kY ].size();
+    auto xSize = xCoords_.size();
+    auto ySize = yCoords_.size();
 
-    std :: vector<std :: vector<double>> grid( ySize, std :: vector<double>( xSize ) );
+    // vector output draws the cells themselves, width and height only size the canvas
+    if( native && format == ImageFormat :: SVG )
+    {
+        double plotWidth    =   width > 0 ? width  : SVG_PLOT_WIDTH;
+        double plotHeight   =   width > 0 ? height : SVG_PLOT_WIDTH * axisExtent( yCoords_ ) / axisExtent( xCoords_ );
+
+        if( levels.empty() && scaling.scale == ColorScale :: BREAKS )
+            levels = scaling.breaks;
+
+        std :: ostringstream svg;
+        {
+            TIME_PHASE( Metrics :: RENDER );
+            writeSVG( svg, slice->data(), *colormap, scaling, levels, plotWidth, plotHeight );
+        }
+        return bodyResponse( *imageCache_.insert( cacheKey, svg.str() ), contentType );
+    }
+
+    if( native )
+    {
+        const double*           pixels  =   slice->data();
+        std :: vector<double>   resampled;
+
+        if( width > 0 )
+        {
+            TIME_PHASE( Metrics :: TRANSFORM );
+
+            resampled.resize( width * height );
+            resample( slice->data(), 
+                      xSize, 
+                      resampleAxis( yCoords_, height, filter ), 
+                      resampleAxis( xCoords_, width, filter ), 
+                      resampled.data() );
+            pixels = resampled.data();
+        }
+        else
+        {
+            width   =   xSize;
+            height  =   ySize;
+        }
+
+        std :: vector<uint8_t>  rgba;
+        {
+            TIME_PHASE( Metrics :: RENDER );
+            rgba = renderRGBA( pixels, height, width, *colormap, scaling );
+        }
+        CancelToken :: checkCurrent();
+
+        std :: shared_ptr<const std :: string> image;
+        try
+        {
+            TIME_PHASE( Metrics :: ENCODE );
+            image = imageCache_.insert( cacheKey, encodeImage( rgba, width, height, *colormap, format, quality ) );
+        }
+        catch( const std :: exception& e )
+        {
+            responseCode_ = 500;
+            result[ kError ] = Errors :: FAIL_S_IMG + e.what();
+            return JSONResponse( result, APPLICATION_JSON );
+        }
+        return bodyResponse( *image, contentType );
+    }
 
-    for( size_t i = 0; i < ySize; i++ ) 
+    std :: vector<std :: vector<double>> grid( ySize, std :: vector<double>( xSize ) );
     {
-        for( size_t j = 0; j < xSize; j++ ) 
+        TIME_PHASE( Metrics :: TRANSFORM );
+
+        for( size_t i = 0; i < ySize; i++ ) 
         {
-            grid[ i ][ j ] = concentrationData_[ i * xSize + j ];
+            for( size_t j = 0; j < xSize; j++ ) 
+            {
+                grid[ i ][ j ] = ( *slice )[ i * xSize + j ];
+            }
         }
     }
 
     // create unique image filename on UUID for better potential heavy concurrency safety
     std :: string uniqueImagePath = generateUniqueFileName( ASSETS_PATH, PNG_EXT );
+    {
+        TIME_PHASE( Metrics :: RENDER );
 
-    // gen image
-    result = generateVisual( grid, uniqueImagePath );
+        // gen image, colored on the level's fixed range so frames are comparable across time
+        result = generateVisual( grid, uniqueImagePath, dataset()->summaryIndex.range( zIndex_ ) );
 
-    if( result.count( kError ) > 0 )
-    {
-        responseCode_ = 500;
-        return JSONResponse( result, APPLICATION_JSON );
-    }
+        if( result.count( kError ) > 0 )
+        {
+            responseCode_ = 500;
+            return JSONResponse( result, APPLICATION_JSON );
+        }
 
-    // give some time for generateVisual to complete, check every 100 mills, time out after 2 seconds
-    if( !waitForFile( uniqueImagePath, 2000, 100 ) ) 
-    {  
-        responseCode_ = 500;
-        result[ kError ] = Errors :: PNG_TIMEOUT;
-        return JSONResponse( result, APPLICATION_JSON );
+        // give some time for generateVisual to complete, check every 100 mills, time out after 2 seconds
+        if( !waitForFile( uniqueImagePath, 2000, 100 ) ) 
+        {  
+            responseCode_ = 500;
+            result[ kError ] = Errors :: PNG_TIMEOUT;
+            return JSONResponse( result, APPLICATION_JSON );
+        }
     }
 
+    // matplot++ encodes as it saves, what is left of encoding is getting the png back into memory
+    TIME_PHASE( Metrics :: ENCODE );
+
     std :: ifstream file;
 
     // read image and return response
@@ -365,120 +779,1955 @@ Response NetCDFServer :: handleGetImage( const Request& request )
     return response;
 }
 
-// generate robust unique file name using UUID for potential heavy concurrency
-std :: string NetCDFServer :: generateUniqueFileName( const std :: string& path, 
-                                                      const std :: string& extension )
+/*+++++++++++++++++*
+|  handleGetStats  |
+*++++++++++++++++++/
+
+/*!
+    function for get-stats - params to include time index and z index, with optional 
+    time_end ( inclusive ) to reduce over a run of time steps, bbox=xmin,ymin,xmax,ymax 
+    in x/y coordinate units to restrict the plane, and percentiles=p1,p2,... in [0, 100].
+    returns count, min, max, mean, sum, variance, nonzero and approximate percentiles, 
+    plus a per time step breakdown when more than one step is reduced.
+*/
+Response NetCDFServer :: handleGetStats( const Request& request )
 {
-    std :: stringstream ss;
-    std :: random_device rd;
-    std :: mt19937 gen( rd() );
-    std :: uniform_int_distribution<> dis( 0, 15 );
-    std :: uniform_int_distribution<> dis2( 8, 11 ); 
+    JSONValue   result;
+    Region      region;
+    uint        timeEnd;
 
-    ss << path ;
-    for ( int i = 0; i < 8; i++ ) ss << std :: hex << dis( gen );
-    ss << "-";
-    for ( int i = 0; i < 4; i++ ) ss << std :: hex << dis( gen );
-    ss << "-4"; 
-    for ( int i = 0; i < 3; i++ ) ss << std :: hex << dis( gen );
-    ss << "-";
-    ss << std :: hex << dis2( gen );
-    for ( int i = 0; i < 3; i++ )  ss << std :: hex << dis( gen );
-    ss << "-";
-    for ( int i = 0; i < 12; i++ ) ss << std :: hex << dis( gen );
-    ss << extension;
+    if( !validateRequestParameters( request,
+                                    result,
+                                    timeIndex_,
+                                    zIndex_,
+                                    { "time_end", "bbox", "percentiles" } ) )
+        return JSONResponse( result, APPLICATION_JSON );
 
-    std :: string uniqueImagePath = ss.str();
+    if( !parseRegion( request, result, region ) )
+        return JSONResponse( result, APPLICATION_JSON );
 
-    return uniqueImagePath;
-}
+    auto query = request.url_params;
 
-// extract one x, y slice given z and time
-JSONValue NetCDFServer :: extractNetCDFSlice( uint& timeIndex, uint& zIndex )  
-{
-    JSONValue result;
+    if( !parseTimeEnd( request, result, timeIndex_, timeEnd ) )
+        return JSONResponse( result, APPLICATION_JSON );
 
-    try 
+    std :: vector<double> percentiles;
+    if( query.get( "percentiles" ) )
     {
-        // retrieve x and y variables
-        auto x = dataFile_.getVar( kX );
-        auto y = dataFile_.getVar( kY );
+        bool valid = parseDoubleList( query.get( "percentiles" ), percentiles ) && 
+                     std :: all_of( percentiles.begin(), percentiles.end(), []( double p ) { return p >= 0.0 && p <= 100.0; } );
 
-        // get sizes of only occurrences of x and y
-        std :: vector<double> xData( x.getDim( 0 ).getSize() );
-        std :: vector<double> yData( y.getDim( 0 ).getSize() );
+        if( !valid )
+        {
+            responseCode_ = 400;
+            result[ kError ] = Errors :: INVALID_PCTL;
+            return JSONResponse( result, APPLICATION_JSON );
+        }
+    }
 
-        // use getVar( double * dataValues ) to fill the vector buffers from the x and y variables
-        x.getVar( xData.data() );
-        y.getVar( yData.data() );
+    // keyed like the response's ETag, so estimateCost can tell a hit before queuing
+    std :: string key = entityTag( request );
+    if( auto cached = statsCache_.find( key ) )
+        return bodyResponse( *cached, APPLICATION_JSON );
 
-        // retrieve the concentration variable
-        auto concentration = dataFile_.getVar( kConcentration );
-        
-        // initialize vector to receive x*y concentration doubles
-        concentrationData_.resize( yData.size() * xData.size() );
+    size_t timeCount    =   timeEnd - timeIndex_ + 1;
+    size_t planeSize    =   region.ny * region.nx;
 
-        // use getVar( vector start, vector count, double * dataValues ) to fill the concentration vector buffer of doubles
-        // pulling out count = { 1, 1, y, x }
-        concentration.getVar
-        ( 
-            {
-                static_cast<size_t>( timeIndex ), static_cast<size_t>( zIndex ), 0, 0
-            },
-            {
-                1, 1, yData.size(), xData.size() 
-            },
-            concentrationData_.data() 
-         );
+    std :: vector<RunningStats> steps( timeCount );
+    LogHistogram                histogram;
 
-        // store results in JSON - x, y and concentration JSON arrays
-        JSONList xList( xData.begin() , xData.end() );  
-        JSONList yList( yData.begin() , yData.end() );
-        JSONList concentrationList;
+    try
+    {
+        // bound memory by reading batches of time steps, reduce each step in parallel
+        size_t batchSize = std :: max<size_t>( 1, STATS_BATCH_VALUES / std :: max<size_t>( 1, planeSize ) );
+        std :: vector<double> values;
 
-        // transform the 1D concentrationData_ into 2D
-        for( size_t i = 0; i < yData.size(); i++ )  
+        for( size_t batchStart = 0; batchStart < timeCount; batchStart += batchSize )
         {
-            JSONList row;
+            size_t batchCount = std :: min( batchSize, timeCount - batchStart );
 
-            for( size_t j = 0; j < xData.size(); j++ )  
-            {
-                // push x items per y row
-                row.push_back( concentrationData_[ i * xData.size() + j ] );
-            }
-            // add y row
-            concentrationList.push_back( std :: move( row ) );
-        }
+            values.resize( batchCount * planeSize );
+            readConcentration( timeIndex_ + batchStart, batchCount, zIndex_, region, values.data() );
 
-        // move
-        result[ kX ] = std :: move( xList );
-        result[ kY ] = std :: move( yList );
-        result[ kConcentration ] = std :: move( concentrationList );
+            std :: vector<LogHistogram> histograms( percentiles.empty() ? 0 : batchCount );
 
-        /* maybe better for potential reuse
-        auto to2DJSON = [ & ]( const std :: vector<double>& vector1D, size_t rows, size_t cols) -> JSONList 
-        {
-            JSONList result;
-            for ( size_t i = 0; i < rows; ++i ) 
+            parallelFor( batchCount, [ & ]( size_t i )
             {
-                JSONList row;
-                for ( size_t j = 0; j < cols; ++j ) 
-                {
-                    row.push_back( vector1D[ i * cols + j ] );
-                }
-                result.push_back( std :: move( row ) );
+                const double* plane = values.data() + i * planeSize;
+
+                steps[ batchStart + i ].add( plane, planeSize );
+                if( !percentiles.empty() )
+                    histograms[ i ].add( plane, planeSize );
+            } );
+
+            for( const auto& h : histograms )
+                histogram.merge( h );
+        }
+    }
+    catch( const std :: exception& e )
+    {
+        responseCode_ = 500;
+        result[ kError ] = Errors :: FAIL_STATS + e.what();
+        return JSONResponse( result, APPLICATION_JSON );
+    }
+
+    auto toJSON = []( const RunningStats& stats ) -> JSONValue
+    {
+        JSONValue json;
+        json[ "count" ]     =   stats.count;
+        json[ "nonzero" ]   =   stats.nonzero;
+        json[ "min" ]       =   jsonNumber( stats.min );
+        json[ "max" ]       =   jsonNumber( stats.max );
+        json[ "mean" ]      =   jsonNumber( stats.mean );
+        json[ "sum" ]       =   jsonNumber( stats.sum );
+        json[ "variance" ]  =   jsonNumber( stats.variance() );
+        json[ "stddev" ]    =   jsonNumber( std :: sqrt( stats.variance() ) );
+        return json;
+    };
+
+    RunningStats total;
+    for( const auto& step : steps )
+        total.merge( step );
+
+    result = toJSON( total );
+
+    result[ kTime ]     =   JSONList{ timeIndex_, timeEnd };
+    result[ kZ ]        =   zIndex_;
+    result[ "bbox" ]    =   JSONList{ xCoords_[ region.x0 ], 
+                                      yCoords_[ region.y0 ], 
+                                      xCoords_[ region.x0 + region.nx - 1 ], 
+                                      yCoords_[ region.y0 + region.ny - 1 ] };
+
+    if( !percentiles.empty() )
+    {
+        JSONMap percentileValues;
+        for( double p : percentiles )
+        {
+            std :: ostringstream name;
+            name << p;
+            percentileValues[ name.str() ] = jsonNumber( histogram.quantile( p / 100.0, total.min, total.max ) );
+        }
+        result[ "percentiles" ] = std :: move( percentileValues );
+    }
+
+    if( timeCount > 1 )
+    {
+        auto        data    =   dataset();
+        JSONList    stepList;
+        for( size_t i = 0; i < timeCount; i++ )
+        {
+            JSONValue step = toJSON( steps[ i ] );
+            step[ kTime ] = data->timeCoords[ timeIndex_ + i ];
+            stepList.push_back( std :: move( step ) );
+        }
+        result[ "time_steps" ] = std :: move( stepList );
+    }
+
+    auto body = statsCache_.insert( key, result.dump( 3 ) );
+    return bodyResponse( *body, APPLICATION_JSON );
+}
+
+/*++++++++++++++++*
+|  handleGetDose  |
+*+++++++++++++++++/
+
+/*!
+    function for get-dose - params to include time index and z index, 
+    returns the dosage ( time integral of concentration ) at every grid cell from the 
+    first time step up to and including the requested one, trapezoidal over the time coordinate.
+*/
+Response NetCDFServer :: handleGetDose( const Request& request )
+{
+    JSONValue   result;
+
+    if( !validateRequestParameters( request, 
+                                    result, 
+                                    timeIndex_, 
+                                    zIndex_ ) )
+        return JSONResponse( result, APPLICATION_JSON );
+
+    std :: shared_ptr<const std :: vector<double>> dose;
+
+    try
+    {
+        dose = cumulativeDose( timeIndex_, zIndex_ );
+    }
+    catch( const std :: exception& e )
+    {
+        responseCode_ = 500;
+        result[ kError ] = Errors :: FAIL_DOSE + e.what();
+        return JSONResponse( result, APPLICATION_JSON );
+    }
+
+    auto data = dataset();
+
+    result[ kX ]            =   JSONList( xCoords_.begin(), xCoords_.end() );
+    result[ kY ]            =   JSONList( yCoords_.begin(), yCoords_.end() );
+    result[ "time_start" ]  =   data->timeCoords.front();
+    result[ "time_end" ]    =   data->timeCoords[ timeIndex_ ];
+    result[ "dose" ]        =   to2DJSON( *dose, yCoords_.size(), xCoords_.size() );
+
+    return JSONResponse( result, APPLICATION_JSON );
+}
+
+/*++++++++++++++++++++*
+|  handleGetContours  |
+*+++++++++++++++++++++/
+
+/*!
+    function for get-contours - params to include time index, z index and levels=l1,l2,...
+    returns a GeoJSON FeatureCollection with one MultiPolygon feature per level, covering 
+    the cells where concentration >= level, in x/y coordinate units.
+*/
+Response NetCDFServer :: handleGetContours( const Request& request )
+{
+    JSONValue               result;
+    std :: vector<double>   levels;
+
+    if( !validateRequestParameters( request, 
+                                    result, 
+                                    timeIndex_, 
+                                    zIndex_,
+                                    { "levels" } ) )
+        return JSONResponse( result, APPLICATION_JSON );
+
+    auto query = request.url_params;
+    if( !query.get( "levels" ) || !parseDoubleList( query.get( "levels" ), levels ) )
+    {
+        responseCode_ = 400;
+        result[ kError ] = Errors :: INVALID_LEVELS;
+        return JSONResponse( result, APPLICATION_JSON );
+    }
+
+    std :: sort( levels.begin(), levels.end() );
+    levels.erase( std :: unique( levels.begin(), levels.end() ), levels.end() );
+
+    std :: string key = entityTag( request );
+    if( auto cached = contourCache_.find( key ) )
+        return bodyResponse( *cached, APPLICATION_GEOJSON );
+
+    Region                  plane{ 0, yCoords_.size(), 0, xCoords_.size() };
+    std :: vector<double>   values( plane.ny * plane.nx );
+
+    try
+    {
+        readConcentration( timeIndex_, 1, zIndex_, plane, values.data() );
+    }
+    catch( const std :: exception& e )
+    {
+        responseCode_ = 500;
+        result[ kError ] = Errors :: EXTRACT_NCDF + e.what();
+        return JSONResponse( result, APPLICATION_JSON );
+    }
+
+    // levels are independent, trace them in parallel
+    std :: vector<std :: vector<Polygon>> polygonsPerLevel( levels.size() );
+    parallelFor( levels.size(), [ & ]( size_t i )
+    {
+        polygonsPerLevel[ i ] = contourPolygons( values.data(), xCoords_, yCoords_, levels[ i ] );
+    } );
+
+    JSONList features;
+    for( size_t i = 0; i < levels.size(); i++ )
+    {
+        JSONList multiPolygon;
+        for( const auto& polygon : polygonsPerLevel[ i ] )
+        {
+            JSONList rings;
+            for( const auto& ring : polygon )
+            {
+                JSONList points;
+                for( const auto& point : ring )
+                    points.push_back( JSONList{ point[ 0 ], point[ 1 ] } );
+                rings.push_back( std :: move( points ) );
+            }
+            multiPolygon.push_back( std :: move( rings ) );
+        }
+
+        JSONValue geometry;
+        geometry[ "type" ]          =   "MultiPolygon";
+        geometry[ "coordinates" ]   =   std :: move( multiPolygon );
+
+        JSONValue properties;
+        properties[ "level" ]       =   levels[ i ];
+        properties[ kTime ]         =   dataset()->timeCoords[ timeIndex_ ];
+        properties[ kZ ]            =   zIndex_;
+
+        JSONValue feature;
+        feature[ "type" ]           =   "Feature";
+        feature[ "properties" ]     =   std :: move( properties );
+        feature[ "geometry" ]       =   std :: move( geometry );
+        features.push_back( std :: move( feature ) );
+    }
+
+    result[ "type" ]        =   "FeatureCollection";
+    result[ "features" ]    =   std :: move( features );
+
+    // compact, geometry is the bulk of the payload
+    auto body = contourCache_.insert( key, result.dump() );
+    return bodyResponse( *body, APPLICATION_GEOJSON );
+}
+
+/*++++++++++++++++++++++*
+|  handleGetExceedance  |
+*+++++++++++++++++++++++/
+
+/*!
+    function for get-exceedance - params to include time index, z index and level, optional bbox.
+    returns the count and area of cells where concentration >= level, and a base64 packed 
+    bitmask, one bit per cell in row-major ( y, x ) order, bit k of byte b being cell 8b + k.
+    With time_end the steps time..time_end are swept in parallel and only the per step 
+    count and area are returned.
+*/
+Response NetCDFServer :: handleGetExceedance( const Request& request )
+{
+    JSONValue   result;
+    Region      region;
+    uint        timeEnd;
+    double      level;
+
+    if( !validateRequestParameters( request, 
+                                    result, 
+                                    timeIndex_, 
+                                    zIndex_,
+                                    { "level", "time_end", "bbox" } ) )
+        return JSONResponse( result, APPLICATION_JSON );
+
+    if( !parseRegion( request, result, region ) || !parseTimeEnd( request, result, timeIndex_, timeEnd ) )
+        return JSONResponse( result, APPLICATION_JSON );
+
+    auto query = request.url_params;
+    std :: vector<double> levels;
+    if( !query.get( "level" ) || !parseDoubleList( query.get( "level" ), levels ) || levels.size() != 1 )
+    {
+        responseCode_ = 400;
+        result[ kError ] = Errors :: INVALID_LEVEL;
+        return JSONResponse( result, APPLICATION_JSON );
+    }
+    level = levels[ 0 ];
+
+    size_t timeCount    =   timeEnd - timeIndex_ + 1;
+    size_t planeSize    =   region.ny * region.nx;
+    size_t words        =   ( planeSize + 63 ) / 64;
+
+    // per cell area from the spacing around each node
+    auto xWidths = cellWidths( xCoords_ );
+    auto yWidths = cellWidths( yCoords_ );
+
+    std :: vector<uint64_t>         counts( timeCount );
+    std :: vector<double>           areas( timeCount );
+    std :: vector<uint64_t>         mask( timeCount == 1 ? words : 0 );
+
+    try
+    {
+        size_t batchSize = std :: max<size_t>( 1, STATS_BATCH_VALUES / std :: max<size_t>( 1, planeSize ) );
+        std :: vector<double> values;
+
+        for( size_t batchStart = 0; batchStart < timeCount; batchStart += batchSize )
+        {
+            size_t batchCount = std :: min( batchSize, timeCount - batchStart );
+
+            values.resize( batchCount * planeSize );
+            readConcentration( timeIndex_ + batchStart, batchCount, zIndex_, region, values.data() );
+
+            parallelFor( batchCount, [ & ]( size_t i )
+            {
+                const double*           plane = values.data() + i * planeSize;
+                std :: vector<uint64_t> local( mask.empty() ? words : 0 );
+                uint64_t*               bits  = mask.empty() ? local.data() : mask.data();
+
+                counts[ batchStart + i ] = thresholdMask( plane, planeSize, level, bits );
+
+                // area row by row from the mask, skipping empty words
+                double area = 0.0;
+                for( size_t w = 0; w < words; w++ )
+                {
+                    for( uint64_t word = bits[ w ]; word; word &= word - 1 )
+                    {
+                        size_t cell = w * 64 + __builtin_ctzll( word );
+                        area += yWidths[ region.y0 + cell / region.nx ] * xWidths[ region.x0 + cell % region.nx ];
+                    }
+                }
+                areas[ batchStart + i ] = area;
+            } );
+        }
+    }
+    catch( const std :: exception& e )
+    {
+        responseCode_ = 500;
+        result[ kError ] = Errors :: EXTRACT_NCDF + e.what();
+        return JSONResponse( result, APPLICATION_JSON );
+    }
+
+    result[ "level" ]   =   level;
+    result[ kZ ]        =   zIndex_;
+    result[ "bbox" ]    =   JSONList{ xCoords_[ region.x0 ], 
+                                      yCoords_[ region.y0 ], 
+                                      xCoords_[ region.x0 + region.nx - 1 ], 
+                                      yCoords_[ region.y0 + region.ny - 1 ] };
+
+    if( timeCount == 1 )
+    {
+        // little-endian bytes so bit order does not depend on the host
+        std :: string bytes( ( planeSize + 7 ) / 8, '\0' );
+        for( size_t b = 0; b < bytes.size(); b++ )
+            bytes[ b ] = static_cast<char>( ( mask[ b / 8 ] >> ( 8 * ( b % 8 ) ) ) & 0xff );
+
+        result[ kTime ]     =   timeIndex_;
+        result[ "count" ]   =   counts[ 0 ];
+        result[ "area" ]    =   areas[ 0 ];
+        result[ "shape" ]   =   JSONList{ region.ny, region.nx };
+        result[ "mask" ]    =   crow :: utility :: base64encode( bytes, bytes.size() );
+
+        return JSONResponse( result, APPLICATION_JSON );
+    }
+
+    auto        data    =   dataset();
+    JSONList    steps;
+    for( size_t i = 0; i < timeCount; i++ )
+    {
+        JSONValue step;
+        step[ kTime ]       =   data->timeCoords[ timeIndex_ + i ];
+        step[ "count" ]     =   counts[ i ];
+        step[ "area" ]      =   areas[ i ];
+        steps.push_back( std :: move( step ) );
+    }
+
+    size_t peak = std :: max_element( areas.begin(), areas.end() ) - areas.begin();
+
+    result[ kTime ]             =   JSONList{ timeIndex_, timeEnd };
+    result[ "max_area" ]        =   areas[ peak ];
+    result[ "max_area_time" ]   =   data->timeCoords[ timeIndex_ + peak ];
+    result[ "time_steps" ]      =   std :: move( steps );
+
+    return JSONResponse( result, APPLICATION_JSON );
+}
+
+/*+++++++++++++++*
+|  handleGetRaw  |
+*++++++++++++++++/
+
+/*!
+    function for get-raw - params to include time index and z index, optional time_end.
+    returns concentration[ time..time_end ][ z ] as little-endian float64 in C order, so 
+    byte offset 8 * ( ( t * ny + y ) * nx + x ) is cell ( time + t, z, y, x ). A single 
+    Range is honoured ( If-Range permitting ) and only the rows it covers are read, so 
+    interrupted or parallel chunked downloads never re-read the whole hyperslab.
+*/
+Response NetCDFServer :: handleGetRaw( const Request& request )
+{
+    JSONValue   result;
+    uint        timeEnd;
+
+    if( !validateRequestParameters( request, 
+                                    result, 
+                                    timeIndex_, 
+                                    zIndex_,
+                                    { "time_end" } ) )
+        return JSONResponse( result, APPLICATION_JSON );
+
+    if( !parseTimeEnd( request, result, timeIndex_, timeEnd ) )
+        return JSONResponse( result, APPLICATION_JSON );
+
+    size_t      timeCount   =   timeEnd - timeIndex_ + 1;
+    uint64_t    size        =   uint64_t( timeCount ) * yCoords_.size() * xCoords_.size() * sizeof( double );
+    uint64_t    first       =   0;
+    uint64_t    last        =   size - 1;
+
+    // a Range against an older version of the resource gets the whole new one
+    ByteRange   range       =   ByteRange :: FULL;
+    std :: string ifRange   =   request.get_header_value( "If-Range" );
+    if( ifRange.empty() || ifRange == entityTag( request ) )
+        range = parseByteRange( request.get_header_value( "Range" ), size, first, last );
+
+    Response response;
+
+    if( range == ByteRange :: UNSATISFIABLE )
+    {
+        response.code = 416;
+        response.set_header( "Accept-Ranges", "bytes" );
+        response.set_header( "Content-Range", "bytes */" + std :: to_string( size ) );
+        response.set_header( "Cache-Control", NO_CACHE_NO_STORE );
+        return response;
+    }
+
+    try
+    {
+        // up to a slice is answered from memory, anything larger is spooled a slice at a time
+        uint64_t planeBytes = uint64_t( yCoords_.size() ) * xCoords_.size() * sizeof( double );
+        if( last - first + 1 > planeBytes )
+        {
+            response = spooledResponse( BIN_EXT, last - first + 1, [ &, timeIndex = timeIndex_, zIndex = zIndex_ ]( std :: ostream& out )
+            {
+                readByteRange( timeIndex, zIndex, first, last, out );
+            } );
+            if( response.code != 200 )
+                return response;
+        }
+        else
+        {
+            std :: ostringstream out;
+            readByteRange( timeIndex_, zIndex_, first, last, out );
+            response.body = out.str();
+        }
+    }
+    catch( const std :: exception& e )
+    {
+        responseCode_ = 500;
+        result[ kError ] = Errors :: FAIL_RAW + e.what();
+        return JSONResponse( result, APPLICATION_JSON );
+    }
+
+    response.code = 200;
+    if( range == ByteRange :: PARTIAL )
+    {
+        response.code = 206;
+        response.set_header( "Content-Range", "bytes " + std :: to_string( first ) + "-" + std :: to_string( last ) + "/" + std :: to_string( size ) );
+    }
+    response.set_header( "Accept-Ranges", "bytes" );
+    response.set_header( "X-Array-Shape", std :: to_string( timeCount ) + "," + std :: to_string( yCoords_.size() ) + "," + std :: to_string( xCoords_.size() ) );
+    response.set_header( "X-Array-Dtype", "<f8" );
+    response.set_header( "Content-Type", OCTET_STREAM );
+    return response;
+}
+
+/*+++++++++++++++++++++*
+|  handleGetAnimation  |
+*++++++++++++++++++++++/
+
+/*!
+    function for get-animation - params to include z index and the time indices from and to 
+    ( inclusive ), optional format = apng ( default ) | gif, delay in milliseconds per frame 
+    and any of the native get-image parameters. Every frame is colored on the same scale 
+    ( the level's range over all time steps unless vmin / vmax say otherwise ), so frames 
+    are comparable; they are rendered in parallel and the encoded file is cached.
+*/
+Response NetCDFServer :: handleGetAnimation( const Request& request )
+{
+    JSONValue       result;
+    const Colormap* colormap    =   nullptr;
+    ColorScaling    scaling;
+    size_t          width       =   0;
+    size_t          height      =   0;
+    ResampleFilter  filter      =   ResampleFilter :: BILINEAR;
+    size_t          zIndex      =   0;
+    size_t          from        =   0;
+    size_t          to          =   0;
+    size_t          delay       =   DEFAULT_FRAME_DELAY_MS;
+
+    auto query = request.url_params;
+
+    for( const auto& key : query.keys() )
+    {
+        bool known = key == kZ || key == "from" || key == "to" || key == "format" || key == "delay" || 
+                     std :: find( IMAGE_PARAMETERS.begin(), IMAGE_PARAMETERS.end(), key ) != IMAGE_PARAMETERS.end();
+        if( !known )
+        {
+            responseCode_ = 400;
+            result[ kError ] = Errors :: INVALID_PARM + key + ".";
+            return JSONResponse( result, APPLICATION_JSON );
+        }
+    }
+
+    auto data = dataset();
+    if( !parseIndex( query.get( kZ ), data->summaryIndex.zSize(), zIndex ) ||
+        !parseIndex( query.get( "from" ), data->timeCoords.size(), from ) ||
+        !parseIndex( query.get( "to" ), data->timeCoords.size(), to ) || 
+        to < from )
+    {
+        responseCode_ = 400;
+        result[ kError ] = Errors :: INVALID_FRAMES;
+        return JSONResponse( result, APPLICATION_JSON );
+    }
+
+    std :: string format = query.get( "format" ) ? query.get( "format" ) : "apng";
+    if( format != "apng" && format != "gif" )
+    {
+        responseCode_ = 400;
+        result[ kError ] = Errors :: INVALID_ANIFMT;
+        return JSONResponse( result, APPLICATION_JSON );
+    }
+
+    if( query.get( "delay" ) && ( !parseIndex( query.get( "delay" ), 10001, delay ) || delay < 10 ) )
+    {
+        responseCode_ = 400;
+        result[ kError ] = Errors :: INVALID_DELAY;
+        return JSONResponse( result, APPLICATION_JSON );
+    }
+
+    // the default color range is the level's
+    if( !parseColorScaling( request, result, zIndex, colormap, scaling ) || 
+        !parseImageSize( request, result, width, height, filter ) )
+        return JSONResponse( result, APPLICATION_JSON );
+
+    bool resized = width > 0;
+    if( !resized )
+    {
+        width   =   xCoords_.size();
+        height  =   yCoords_.size();
+    }
+
+    size_t frameCount = to - from + 1;
+    if( frameCount * width * height > MAX_ANIMATION_PIXELS )
+    {
+        responseCode_ = 400;
+        result[ kError ] = Errors :: ANIMATION_SIZE + std :: to_string( MAX_ANIMATION_PIXELS ) + ".";
+        return JSONResponse( result, APPLICATION_JSON );
+    }
+
+    const std :: string& contentType = format == "gif" ? IMAGE_GIF : IMAGE_APNG;
+
+    std :: string key = entityTag( request );
+    if( auto cached = animationCache_.find( key ) )
+        return bodyResponse( *cached, contentType );
+
+    std :: shared_ptr<const std :: string> animation;
+    try
+    {
+        bool coalesced = false;
+        animation = animationFlight_.run( key, [ & ]
+        {
+            ResampleAxis    rows;
+            ResampleAxis    cols;
+            if( resized )
+            {
+                rows = resampleAxis( yCoords_, height, filter );
+                cols = resampleAxis( xCoords_, width, filter );
+            }
+
+            // slices are read under the NetCDF lock one at a time, while other frames render
+            std :: vector<std :: vector<uint8_t>> frames( frameCount );
+            parallelFor( frameCount, [ & ]( size_t i )
+            {
+                auto                    slice   =   readSlice( from + i, zIndex );
+                const double*           pixels  =   slice->data();
+                std :: vector<double>   resampled;
+
+                if( resized )
+                {
+                    TIME_PHASE( Metrics :: TRANSFORM );
+
+                    resampled.resize( width * height );
+                    resample( slice->data(), xCoords_.size(), rows, cols, resampled.data() );
+                    pixels = resampled.data();
+                }
+
+                TIME_PHASE( Metrics :: RENDER );
+                frames[ i ] = renderRGBA( pixels, height, width, *colormap, scaling );
+            } );
+
+            CancelToken :: checkCurrent();
+            TIME_PHASE( Metrics :: ENCODE );
+
+            if( format == "apng" )
+            {
+                std :: vector<const uint8_t*> rgba;
+                for( const auto& frame : frames )
+                    rgba.push_back( frame.data() );
+
+                return encodeAPNG( rgba, width, height, static_cast<uint16_t>( delay ) );
+            }
+
+            // GIF holds 256 colors, the colormap's palette
+            std :: vector<std :: vector<uint8_t>> indexed( frameCount );
+            parallelFor( frameCount, [ & ]( size_t i )
+            {
+                indexed[ i ].resize( width * height );
+                colormap->toPaletteIndices( frames[ i ].data(), width * height, indexed[ i ].data() );
+                std :: vector<uint8_t>().swap( frames[ i ] );
+            } );
+
+            std :: vector<const uint8_t*> indices;
+            for( const auto& frame : indexed )
+                indices.push_back( frame.data() );
+
+            return encodeGIF( indices, width, height, colormap->palette(), 0, static_cast<uint16_t>( ( delay + 5 ) / 10 ) );
+        }, coalesced );
+
+        if( coalesced )
+            Metrics :: recordCoalesced();
+    }
+    catch( const std :: exception& e )
+    {
+        responseCode_ = 500;
+        result[ kError ] = Errors :: FAIL_ANIMATION + e.what();
+        return JSONResponse( result, APPLICATION_JSON );
+    }
+
+    animation = animationCache_.insert( key, animation );
+    return bodyResponse( *animation, contentType );
+}
+
+/*+++++++++++++++++++++*
+|  /subscribe feed     |
+*++++++++++++++++++++++/
+
+/*!
+    websocket upgrade params: z, optional bbox, format ( json or raw ) and dataset. 
+    dataset, when given, must name this server's data file ( full path or file name ).
+*/
+bool NetCDFServer :: parseSubscription( const Request& request, JSONValue& result, Subscription& subscription )
+{
+    auto query = request.url_params;
+
+    for( const auto& key : query.keys() )
+    {
+        if( key != kZ && key != "bbox" && key != "format" && key != "dataset" )
+        {
+            result[ kError ] = Errors :: INVALID_PARM + key + ".";
+            return false;
+        }
+    }
+
+    if( query.get( "dataset" ) )
+    {
+        std :: string dataset = query.get( "dataset" );
+        if( dataset != fileName_ && dataset != std :: filesystem :: path( fileName_ ).filename().string() )
+        {
+            result[ kError ] = Errors :: UNKNOWN_DATASET + std :: filesystem :: path( fileName_ ).filename().string() + ".";
+            return false;
+        }
+    }
+
+    size_t zSize = dataset()->summaryIndex.zSize();
+    try
+    {
+        subscription.zIndex = query.get( kZ ) ? std :: stoul( query.get( kZ ) ) : 0;
+    }
+    catch( const std :: exception& e )
+    {
+        result[ kError ] = Errors :: FAIL_STOI + e.what();
+        return false;
+    }
+    if( subscription.zIndex >= zSize )
+    {
+        result[ kError ] = std :: string( kZ ) + Errors :: INDEX_OOR + std :: to_string( zSize - 1 ) + ".";
+        return false;
+    }
+
+    std :: string format = query.get( "format" ) ? query.get( "format" ) : "json";
+    if( format != "json" && format != "raw" )
+    {
+        result[ kError ] = Errors :: INVALID_FORMAT;
+        return false;
+    }
+    subscription.binary = format == "raw";
+
+    return parseRegion( request, result, subscription.region );
+}
+
+void NetCDFServer :: startWatcher()
+{
+    if( watcher_.joinable() )
+        return;
+
+    std :: error_code error;
+    watchedSize_        =   std :: filesystem :: file_size( fileName_, error );
+    watchedTime_        =   std :: filesystem :: last_write_time( fileName_, error );
+    publishedTimeSize_  =   dataset()->timeCoords.size();
+    watchStop_          =   false;
+
+    watcher_ = std :: thread( [ this ] { watchTimeSteps(); } );
+}
+
+void NetCDFServer :: stopWatcher()
+{
+    {
+        std :: lock_guard<std :: mutex> lock( watchMutex_ );
+        watchStop_ = true;
+    }
+    watchWake_.notify_all();
+
+    if( watcher_.joinable() )
+        watcher_.join();
+}
+
+void NetCDFServer :: watchTimeSteps()
+{
+    std :: unique_lock<std :: mutex> lock( watchMutex_ );
+
+    while( !watchWake_.wait_for( lock, std :: chrono :: milliseconds( WATCH_INTERVAL_MS ), [ this ] { return watchStop_; } ) )
+    {
+        lock.unlock();
+        try
+        {
+            publishNewTimeSteps();
+        }
+        catch( const std :: exception& e )
+        {
+            // a writer may be mid-append, the next poll retries
+            CROW_LOG_WARNING << Errors :: FAIL_PUSH << e.what();
+        }
+        lock.lock();
+    }
+}
+
+/*!
+    When the data file changes, reopen it ( an open handle keeps the record count it 
+    was opened with ), make the grown dataset the one requests validate and tag 
+    against, and push every time step past the last published one. 
+    Subscribers are grouped by ( z, region, format ) so each group's slice is read and 
+    encoded once, then the same message goes to every connection in the group.
+    json messages carry time_index, time, z, x0, y0 and concentration[ y ][ x ];
+    raw messages are the time index ( uint64 ), the time value and the region as 
+    float64, all little-endian.
+*/
+void NetCDFServer :: publishNewTimeSteps()
+{
+    std :: error_code   error;
+    auto                size    =   std :: filesystem :: file_size( fileName_, error );
+    auto                time    =   std :: filesystem :: last_write_time( fileName_, error );
+
+    if( error || ( size == watchedSize_ && time == watchedTime_ ) )
+        return;
+
+    // reopen under ncMutex_, so the old handle is closed once no read is using it; 
+    // requests keep reading the steps they were validated against through the new one
+    {
+        std :: lock_guard<std :: mutex>     lock( ncMutex_ );
+        auto                                file    =   std :: make_unique<NcFile>( fileName_, NcFile :: read );
+        std :: swap( dataFile_, file );
+    }
+
+    // new time coordinates, summaries for the new steps and tag, then requests see them; 
+    // get-image and get-animation caches are keyed by the tag, their color range may have moved 
+    // ( which is why they are only immutable with a fixed scale, see colorCacheControl )
+    auto previous   =   dataset();
+    auto current    =   loadDatasetVersion( previous.get() );
+    {
+        std :: lock_guard<std :: mutex> lock( datasetMutex_ );
+        dataset_ = current;
+    }
+    {
+        std :: unique_lock lock( infoMetadataMutex_ );
+        infoMetadataCached_ = false;
+    }
+
+    using GroupKey = std :: tuple<size_t, size_t, size_t, size_t, size_t, bool>;
+
+    for( size_t t = publishedTimeSize_; t < current->timeCoords.size(); t++ )
+    {
+        // later subscribers join from the next step on
+        std :: map<GroupKey, std :: vector<crow :: websocket :: connection*>>   groups;
+        std :: map<GroupKey, Subscription>                                     subscriptions;
+        {
+            std :: lock_guard<std :: mutex> lock( subscribersMutex_ );
+            for( const auto& [ connection, subscription ] : subscribers_ )
+            {
+                const Region&   r   =   subscription.region;
+                GroupKey        key { subscription.zIndex, r.y0, r.ny, r.x0, r.nx, subscription.binary };
+
+                groups[ key ].push_back( connection );
+                subscriptions[ key ] = subscription;
+            }
+        }
+
+        double timeValue = current->timeCoords[ t ];
+
+        std :: vector<double> values;
+        for( const auto& [ key, connections ] : groups )
+        {
+            const Subscription& subscription    =   subscriptions[ key ];
+            const Region&       region          =   subscription.region;
+
+            values.resize( region.ny * region.nx );
+            readConcentration( t, 1, subscription.zIndex, region, values.data() );
+
+            std :: string message;
+            if( subscription.binary )
+            {
+                uint64_t index = t;
+                message.resize( sizeof( index ) + sizeof( timeValue ) + values.size() * sizeof( double ) );
+                std :: memcpy( &message[ 0 ], &index, sizeof( index ) );
+                std :: memcpy( &message[ sizeof( index ) ], &timeValue, sizeof( timeValue ) );
+                std :: memcpy( &message[ sizeof( index ) + sizeof( timeValue ) ], values.data(), values.size() * sizeof( double ) );
+            }
+            else
+            {
+                JSONValue json;
+                json[ "time_index" ]    =   t;
+                json[ kTime ]           =   timeValue;
+                json[ kZ ]              =   subscription.zIndex;
+                json[ "x0" ]            =   region.x0;
+                json[ "y0" ]            =   region.y0;
+                json[ kConcentration ]  =   to2DJSON( values, region.ny, region.nx );
+                message = json.dump();
+            }
+
+            // skip connections that closed while the slice was read
+            std :: lock_guard<std :: mutex> lock( subscribersMutex_ );
+            for( auto* connection : connections )
+            {
+                if( subscribers_.count( connection ) == 0 )
+                    continue;
+
+                if( subscription.binary )
+                    connection->send_binary( message );
+                else
+                    connection->send_text( message );
+            }
+        }
+
+        publishedTimeSize_ = t + 1;
+    }
+
+    // only once everything up to timeSize went out, so a failed read is retried
+    watchedSize_    =   size;
+    watchedTime_    =   time;
+}
+
+// generate robust unique file name using UUID for potential heavy concurrency
+std :: string NetCDFServer :: generateUniqueFileName( const std :: string& path, 
+                                                      const std :: string& extension )
+{
+    std :: stringstream ss;
+    std :: random_device rd;
+    std :: mt19937 gen( rd() );
+    std :: uniform_int_distribution<> dis( 0, 15 );
+    std :: uniform_int_distribution<> dis2( 8, 11 ); 
+
+    ss << path ;
+    for ( int i = 0; i < 8; i++ ) ss << std :: hex << dis( gen );
+    ss << "-";
+    for ( int i = 0; i < 4; i++ ) ss << std :: hex << dis( gen );
+    ss << "-4"; 
+    for ( int i = 0; i < 3; i++ ) ss << std :: hex << dis( gen );
+    ss << "-";
+    ss << std :: hex << dis2( gen );
+    for ( int i = 0; i < 3; i++ )  ss << std :: hex << dis( gen );
+    ss << "-";
+    for ( int i = 0; i < 12; i++ ) ss << std :: hex << dis( gen );
+    ss << extension;
+
+    std :: string uniqueImagePath = ss.str();
+
+    return uniqueImagePath;
+}
+
+// extract one x, y slice given z and time
+JSONValue NetCDFServer :: extractNetCDFSlice( uint& timeIndex, uint& zIndex )  
+{
+    JSONValue result;
+
+    try 
+    {
+        // x and y were read at startup
+        const std :: vector<double>& xData = xCoords_;
+        const std :: vector<double>& yData = yCoords_;
+
+        // initialize vector to receive x*y concentration doubles
+        concentrationData_.resize( yData.size() * xData.size() );
+
+        // pulling out count = { 1, 1, y, x }, under the NetCDF lock like every other read
+        readConcentration( timeIndex, 1, zIndex, Region{ 0, yData.size(), 0, xData.size() }, concentrationData_.data() );
+
+        TIME_PHASE( Metrics :: JSON_BUILD );
+
+        // store results in JSON - x, y and concentration JSON arrays
+        JSONList xList( xData.begin() , xData.end() );  
+        JSONList yList( yData.begin() , yData.end() );
+        JSONList concentrationList;
+
+        // transform the 1D concentrationData_ into 2D
+        for( size_t i = 0; i < yData.size(); i++ )  
+        {
+            JSONList row;
+
+            for( size_t j = 0; j < xData.size(); j++ )  
+            {
+                // push x items per y row
+                row.push_back( jsonNumber( concentrationData_[ i * xData.size() + j ] ) );
+            }
+            // add y row
+            concentrationList.push_back( std :: move( row ) );
+        }
+
+        // move
+        result[ kX ] = std :: move( xList );
+        result[ kY ] = std :: move( yList );
+        result[ kConcentration ] = std :: move( concentrationList );
+
+        /* maybe better for potential reuse
+        auto to2DJSON = [ & ]( const std :: vector<double>& vector1D, size_t rows, size_t cols) -> JSONList 
+        {
+            JSONList result;
+            for ( size_t i = 0; i < rows; ++i ) 
+            {
+                JSONList row;
+                for ( size_t j = 0; j < cols; ++j ) 
+                {
+                    row.push_back( vector1D[ i * cols + j ] );
+                }
+                result.push_back( std :: move( row ) );
+            }
+            return result;
+        };
+        concentrationList = to2DJSON( concentrationData_, yData.size(), xData.size() );
+        */
+
+    } 
+    catch( const std :: exception& e )  
+    {
+        result[ kError ] = Errors :: EXTRACT_NCDF + e.what();
+    }
+    return result;
+}
+
+// whole ( time, z ) plane, read once however many requests ask for it at the same time
+std :: shared_ptr<const std :: vector<double>> NetCDFServer :: readSlice( uint timeIndex, uint zIndex )
+{
+    bool coalesced  =   false;
+    auto slice      =   sliceFlight_.run( sliceKey( timeIndex, zIndex ), [ & ]
+    {
+        Region                  plane{ 0, yCoords_.size(), 0, xCoords_.size() };
+        std :: vector<double>   values( plane.ny * plane.nx );
+
+        readConcentration( timeIndex, 1, zIndex, plane, values.data() );
+        return values;
+    }, coalesced );
+
+    if( coalesced )
+        Metrics :: recordCoalesced();
+
+    return slice;
+}
+
+uint64_t NetCDFServer :: sliceKey( uint timeIndex, uint zIndex )
+{
+    return ( uint64_t( timeIndex ) << 32 ) | zIndex;
+}
+
+// read the x and y coordinate variables once, they back every region lookup
+void NetCDFServer :: loadCoordinates()
+{
+    auto load = [ this ]( const char* name, std :: vector<double>& values )
+    {
+        auto var = dataFile_->getVar( name );
+        values.resize( var.getDim( 0 ).getSize() );
+        var.getVar( values.data() );
+    };
+
+    std :: lock_guard<std :: mutex> lock( ncMutex_ );
+    load( kX, xCoords_ );
+    load( kY, yCoords_ );
+
+    // cells never written read as _FillValue, or the library's default fill for the type
+    auto concentration  =   dataFile_->getVar( kConcentration );
+    auto attributes     =   concentration.getAtts();
+    auto fill           =   attributes.find( "_FillValue" );
+
+    if( fill != attributes.end() )
+        fill->second.getValues( &fillValue_ );
+    else
+        fillValue_ = concentration.getType().getId() == NcType :: nc_FLOAT ? NC_FILL_FLOAT : NC_FILL_DOUBLE;
+}
+
+/*!
+    Time coordinates, per-slice summary table ( loaded from the sidecar when the data 
+    file is unchanged, else scanned past what previous covers ) and tag of the file 
+    dataFile_ has open now.
+*/
+std :: shared_ptr<const NetCDFServer :: DatasetVersion> NetCDFServer :: loadDatasetVersion( const DatasetVersion* previous )
+{
+    auto    version =   std :: make_shared<DatasetVersion>();
+    Region  plane{ 0, yCoords_.size(), 0, xCoords_.size() };
+    size_t  zSize;
+    {
+        std :: lock_guard<std :: mutex> lock( ncMutex_ );
+
+        auto time = dataFile_->getVar( kTime );
+        version->timeCoords.resize( time.getDim( 0 ).getSize() );
+        time.getVar( version->timeCoords.data() );
+
+        zSize = dataFile_->getDim( kZ ).getSize();
+    }
+
+    version->summaryIndex.loadOrBuild( fileName_, 
+                                       version->timeCoords.size(), 
+                                       zSize, 
+                                       plane.ny * plane.nx,
+                                       [ this, &plane ]( size_t timeIndex, size_t zIndex, double* values )
+                                       {
+                                           readConcentration( timeIndex, 1, zIndex, plane, values );
+                                       },
+                                       previous ? &previous->summaryIndex : nullptr );
+
+    version->tag = datasetTag();
+    return version;
+}
+
+std :: shared_ptr<const NetCDFServer :: DatasetVersion> NetCDFServer :: dataset() const
+{
+    std :: lock_guard<std :: mutex> lock( datasetMutex_ );
+    return dataset_;
+}
+
+/*!
+    read concentration( timeStart : timeStart + timeCount, zIndex, region ) into values, C order.
+    Fill values come back as NaN, which every reduction, mask and colormap treats as missing
+    and JSON output writes as null.
+*/
+void NetCDFServer :: readConcentration( size_t timeStart, 
+                                        size_t timeCount, 
+                                        size_t zIndex, 
+                                        const Region& region, 
+                                        double* values )
+{
+    // every multi-slice loop reads through here, so abandoned requests stop between slices
+    CancelToken :: checkCurrent();
+
+    TIME_PHASE( Metrics :: READ );
+    {
+        std :: lock_guard<std :: mutex> lock( ncMutex_ );
+
+        dataFile_->getVar( kConcentration ).getVar
+        (
+            { timeStart, zIndex, region.y0, region.x0 },
+            { timeCount, 1, region.ny, region.nx },
+            values
+        );
+    }
+
+    size_t size = timeCount * region.ny * region.nx;
+    std :: replace( values, values + size, fillValue_, std :: numeric_limits<double> :: quiet_NaN() );
+}
+
+/*!
+    Bytes first..last ( inclusive ) of the C order float64 layout of 
+    concentration[ timeStart.., zIndex ], reading only the whole rows they touch and
+    at most one plane at a time, so memory stays at a slice however long the range.
+*/
+void NetCDFServer :: readByteRange( size_t timeStart, 
+                                    size_t zIndex, 
+                                    uint64_t first, 
+                                    uint64_t last, 
+                                    std :: ostream& out )
+{
+    size_t  nx          =   xCoords_.size();
+    size_t  ny          =   yCoords_.size();
+    size_t  rowBytes    =   nx * sizeof( double );
+
+    // global row numbers across the stacked planes
+    size_t  rowFirst    =   first / rowBytes;
+    size_t  rowLast     =   last / rowBytes;
+
+    std :: vector<double> values;
+
+    for( size_t row = rowFirst; row <= rowLast; )
+    {
+        size_t  t       =   row / ny;
+        size_t  y0      =   row % ny;
+        size_t  rows    =   std :: min( ny - y0, rowLast + 1 - row );
+
+        values.resize( rows * nx );
+        readConcentration( timeStart + t, 1, zIndex, Region{ y0, rows, 0, nx }, values.data() );
+
+        // trim the partial first and last rows
+        uint64_t    begin   =   uint64_t( row ) * rowBytes;
+        uint64_t    from    =   std :: max<uint64_t>( first, begin );
+        uint64_t    to      =   std :: min<uint64_t>( last + 1, begin + rows * rowBytes );
+
+        out.write( reinterpret_cast<const char*>( values.data() ) + ( from - begin ), to - from );
+        row += rows;
+    }
+}
+
+/*!
+    get-data over time..timeEnd as { x, y, time, concentration[ t ][ y ][ x ] }, written
+    straight from one reused slice buffer instead of through a JSON value per cell.
+    Numbers use 17 significant digits ( exact round trip ), non-finite ones are null.
+*/
+void NetCDFServer :: writeSeriesJSON( size_t timeStart, size_t timeEnd, size_t zIndex, std :: ostream& out )
+{
+    char number[ 32 ];
+    auto writeNumber = [ & ]( double value )
+    {
+        if( !std :: isfinite( value ) )
+        {
+            out << "null";
+            return;
+        }
+        out.write( number, std :: snprintf( number, sizeof( number ), "%.17g", value ) );
+    };
+
+    auto writeList = [ & ]( const double* values, size_t size )
+    {
+        out << '[';
+        for( size_t i = 0; i < size; i++ )
+        {
+            if( i > 0 )
+                out << ',';
+            writeNumber( values[ i ] );
+        }
+        out << ']';
+    };
+
+    auto                    data    =   dataset();
+    Region                  plane{ 0, yCoords_.size(), 0, xCoords_.size() };
+    std :: vector<double>   values( plane.ny * plane.nx );
+
+    out << "{\"" << kX << "\":";
+    writeList( xCoords_.data(), xCoords_.size() );
+    out << ",\"" << kY << "\":";
+    writeList( yCoords_.data(), yCoords_.size() );
+    out << ",\"" << kTime << "\":";
+    writeList( data->timeCoords.data() + timeStart, timeEnd - timeStart + 1 );
+    out << ",\"" << kConcentration << "\":[";
+
+    for( size_t t = timeStart; t <= timeEnd; t++ )
+    {
+        readConcentration( t, 1, zIndex, plane, values.data() );
+
+        TIME_PHASE( Metrics :: SERIALIZE );
+        out << ( t > timeStart ? ",[" : "[" );
+        for( size_t i = 0; i < plane.ny; i++ )
+        {
+            if( i > 0 )
+                out << ',';
+            writeList( values.data() + i * plane.nx, plane.nx );
+        }
+        out << ']';
+    }
+    out << "]}";
+}
+
+/*!
+    Running dose D( k ) = D( k - 1 ) + ( t[ k ] - t[ k - 1 ] ) * ( C[ k - 1 ] + C[ k ] ) / 2, D( 0 ) = 0.
+    Resumes from the nearest cached step at or below timeIndex, so stepping forward 
+    in time costs one slice read per new step, and caches every plane it produces. 
+    An interval with a missing ( fill ) value at either end adds nothing to that cell, 
+    so a gap does not leave the cell without a dose from then on. Identical concurrent 
+    requests share one integration.
+*/
+std :: shared_ptr<const std :: vector<double>> NetCDFServer :: cumulativeDose( size_t timeIndex, size_t zIndex )
+{
+    auto    key     =   [ & ]( size_t t ) { return sliceKey( t, zIndex ); };
+    auto    cached  =   doseCache_->find( key( timeIndex ) );
+    if( cached )
+        return cached;
+
+    bool coalesced  =   false;
+    auto dose       =   doseFlight_.run( key( timeIndex ), [ & ]
+    {
+        auto    data        =   dataset();
+        Region  plane{ 0, yCoords_.size(), 0, xCoords_.size() };
+        size_t  planeSize   =   plane.ny * plane.nx;
+
+        // walk back to the latest step already integrated
+        size_t start    = timeIndex;
+        auto   resumed  = doseCache_->find( key( start ) );
+        while( !resumed && start > 0 )
+            resumed = doseCache_->find( key( --start ) );
+
+        std :: vector<double> running = resumed ? *resumed : std :: vector<double>( planeSize, 0.0 );
+        if( start == timeIndex )
+            return running;
+
+        if( !resumed )
+            doseCache_->insert( key( 0 ), running );
+
+        std :: vector<double> previous( planeSize );
+        std :: vector<double> current( planeSize );
+
+        readConcentration( start, 1, zIndex, plane, previous.data() );
+
+        // rows per task, so small grids are not split across threads
+        size_t rowsPerTask  =   std :: max<size_t>( 1, DOSE_TASK_VALUES / std :: max<size_t>( 1, plane.nx ) );
+        size_t tasks        =   ( plane.ny + rowsPerTask - 1 ) / rowsPerTask;
+
+        for( size_t k = start + 1; k <= timeIndex; k++ )
+        {
+            readConcentration( k, 1, zIndex, plane, current.data() );
+
+            double halfStep = 0.5 * ( data->timeCoords[ k ] - data->timeCoords[ k - 1 ] );
+
+            parallelFor( tasks, [ & ]( size_t task )
+            {
+                size_t begin    =   task * rowsPerTask * plane.nx;
+                size_t end      =   std :: min( planeSize, begin + rowsPerTask * plane.nx );
+
+                for( size_t i = begin; i < end; i++ )
+                {
+                    double step = halfStep * ( previous[ i ] + current[ i ] );
+                    running[ i ] += std :: isnan( step ) ? 0.0 : step;
+                }
+            } );
+
+            // the last plane is cached by the caller, without a copy
+            if( k < timeIndex )
+                doseCache_->insert( key( k ), running );
+            std :: swap( previous, current );
+        }
+
+        return running;
+    }, coalesced );
+
+    if( coalesced )
+        Metrics :: recordCoalesced();
+
+    return doseCache_->insert( key( timeIndex ), dose );
+}
+
+// 1D row-major values as rows of JSON lists
+JSONList NetCDFServer :: to2DJSON( const std :: vector<double>& vector1D, size_t rows, size_t cols )
+{
+    JSONList result;
+    for ( size_t i = 0; i < rows; ++i ) 
+    {
+        JSONList row;
+        for ( size_t j = 0; j < cols; ++j ) 
+        {
+            row.push_back( jsonNumber( vector1D[ i * cols + j ] ) );
+        }
+        result.push_back( std :: move( row ) );
+    }
+    return result;
+}
+
+// fill ( NaN ) and empty range ( inf ) values as an explicit null, crow would log a warning for each
+JSONValue NetCDFServer :: jsonNumber( double value )
+{
+    if( !std :: isfinite( value ) )
+        return JSONValue();
+    return JSONValue( value );
+}
+
+/*!
+    Single range forms only: bytes=first-last, bytes=first- and bytes=-suffix, with last 
+    clamped to the body. Anything else is ignored and the full body is sent, which the 
+    spec allows; a range starting past the end ( or an empty suffix ) cannot be satisfied.
+*/
+ByteRange NetCDFServer :: parseByteRange( const std :: string& header, uint64_t size, uint64_t& first, uint64_t& last )
+{
+    const std :: string unit = "bytes=";
+    if( header.compare( 0, unit.size(), unit ) != 0 || header.find( ',' ) != std :: string :: npos )
+        return ByteRange :: FULL;
+
+    std :: string   spec    =   header.substr( unit.size() );
+    auto            dash    =   spec.find( '-' );
+    std :: string   lo      =   spec.substr( 0, dash );
+    std :: string   hi      =   dash == std :: string :: npos ? "" : spec.substr( dash + 1 );
+
+    auto digits = []( const std :: string& text )
+    {
+        return !text.empty() && text.size() < 20 && std :: all_of( text.begin(), text.end(), ::isdigit );
+    };
+
+    if( dash == std :: string :: npos || ( !digits( lo ) && !digits( hi ) ) )
+        return ByteRange :: FULL;
+    if( ( !lo.empty() && !digits( lo ) ) || ( !hi.empty() && !digits( hi ) ) )
+        return ByteRange :: FULL;
+
+    if( lo.empty() )
+    {
+        uint64_t suffix = std :: stoull( hi );
+        if( suffix == 0 || size == 0 )
+            return ByteRange :: UNSATISFIABLE;
+
+        first   =   size - std :: min( suffix, size );
+        last    =   size - 1;
+        return ByteRange :: PARTIAL;
+    }
+
+    first   =   std :: stoull( lo );
+    last    =   hi.empty() ? size - 1 : std :: min<uint64_t>( std :: stoull( hi ), size - 1 );
+
+    if( first >= size )
+        return ByteRange :: UNSATISFIABLE;
+    if( last < first )
+        return ByteRange :: FULL;
+    return ByteRange :: PARTIAL;
+}
+
+bool NetCDFServer :: parseTimeEnd( const Request& request, JSONValue& result, uint timeIndex, uint& timeEnd )
+{
+    auto query = request.url_params;
+
+    timeEnd = timeIndex;
+    if( !query.get( "time_end" ) )
+        return true;
+
+    try
+    {
+        timeEnd = std :: stoi( query.get( "time_end" ) );
+    }
+    catch( const std :: exception& e )
+    {
+        responseCode_ = 400;
+        result[ kError ] = Errors :: FAIL_STOI + e.what();
+        return false;
+    }
+
+    size_t timeSize = dataset()->timeCoords.size();
+    if( timeEnd >= timeSize )
+    {
+        responseCode_ = 400;
+        result[ kError ] = std :: string( kTime ) + Errors :: INDEX_OOR + std :: to_string( timeSize - 1 ) + ".";
+        return false;
+    }
+    if( timeEnd < timeIndex )
+    {
+        responseCode_ = 400;
+        result[ kError ] = Errors :: TIME_END_ORDER;
+        return false;
+    }
+    return true;
+}
+
+// width of the cell around each node, half way to its neighbours
+std :: vector<double> NetCDFServer :: cellWidths( const std :: vector<double>& coords )
+{
+    size_t                  n = coords.size();
+    std :: vector<double>   widths( n, 1.0 );
+
+    if( n < 2 )
+        return widths;
+
+    widths[ 0 ]     =   std :: abs( coords[ 1 ] - coords[ 0 ] );
+    widths[ n - 1 ] =   std :: abs( coords[ n - 1 ] - coords[ n - 2 ] );
+    for( size_t i = 1; i + 1 < n; i++ )
+        widths[ i ] = 0.5 * std :: abs( coords[ i + 1 ] - coords[ i - 1 ] );
+
+    return widths;
+}
+
+/*!
+    Cache-Control for get-image and get-animation. Their default color range is the level's 
+    range over all time steps, which moves when steps are appended, so the same URL can 
+    render differently later and has to be revalidated against the ETag. Only a scale the 
+    query fixes ( breaks, vmin and vmax, or vmax alone for log ) makes the bytes immutable; 
+    the matplot++ figure always uses the default range.
+*/
+const std :: string& NetCDFServer :: colorCacheControl( const Request& request )
+{
+    const auto&     query   =   request.url_params;
+    std :: string   scale   =   query.get( "scale" ) ? query.get( "scale" ) : "linear";
+
+    bool fixed = scale == "breaks" || 
+                 ( query.get( "vmax" ) && ( query.get( "vmin" ) || scale == "log" ) );
+
+    return fixed ? CACHE_IMMUTABLE : CACHE_REVALIDATE;
+}
+
+/*!
+    colormap ( default viridis ), scale = linear ( default ) | log | breaks, lut = 256 | 4096 
+    ( default 4096 for log, 256 otherwise ), breaks for scale=breaks, and vmin / vmax for 
+    linear and log. The default range is level zIndex's range over all time steps, so frames 
+    are comparable across time; for log it spans LOG_DECADES below the level's maximum. 
+    A level with no data at all defaults to [0, 1].
+*/
+bool NetCDFServer :: parseColorScaling( const Request& request, 
+                                        JSONValue& result, 
+                                        size_t zIndex, 
+                                        const Colormap*& colormap, 
+                                        ColorScaling& scaling )
+{
+    auto query = request.url_params;
+
+    std :: string scale = query.get( "scale" ) ? query.get( "scale" ) : "linear";
+    if( scale == "linear" )
+        scaling.scale = ColorScale :: LINEAR;
+    else if( scale == "log" )
+        scaling.scale = ColorScale :: LOG10;
+    else if( scale == "breaks" )
+        scaling.scale = ColorScale :: BREAKS;
+    else
+    {
+        responseCode_ = 400;
+        result[ kError ] = Errors :: INVALID_SCALE;
+        return false;
+    }
+
+    size_t lutSize = scaling.scale == ColorScale :: LOG10 ? Colormap :: LARGE_LUT : Colormap :: SMALL_LUT;
+    if( query.get( "lut" ) )
+    {
+        std :: string lut = query.get( "lut" );
+        lutSize = lut == "256" ? Colormap :: SMALL_LUT : ( lut == "4096" ? Colormap :: LARGE_LUT : 0 );
+        if( lutSize == 0 )
+        {
+            responseCode_ = 400;
+            result[ kError ] = Errors :: INVALID_LUT;
+            return false;
+        }
+    }
+
+    colormap = Colormap :: find( query.get( "colormap" ) ? query.get( "colormap" ) : "viridis", lutSize );
+    if( !colormap )
+    {
+        std :: string names;
+        for( const auto& name : Colormap :: names() )
+            names += ( names.empty() ? "" : ", " ) + name;
+
+        responseCode_ = 400;
+        result[ kError ] = Errors :: INVALID_CMAP + names + ".";
+        return false;
+    }
+
+    if( scaling.scale == ColorScale :: BREAKS )
+    {
+        if( !query.get( "breaks" ) || 
+            !parseDoubleList( query.get( "breaks" ), scaling.breaks ) || 
+            std :: adjacent_find( scaling.breaks.begin(), scaling.breaks.end(), std :: greater_equal<double>() ) != scaling.breaks.end() )
+        {
+            responseCode_ = 400;
+            result[ kError ] = Errors :: INVALID_BREAKS;
+            return false;
+        }
+        return true;
+    }
+
+    // defaults, kept valid even for a level that is all zero
+    auto range = dataset()->summaryIndex.range( zIndex );
+
+    // a level holding only fill values has no range; every cell renders transparent anyway
+    if( !std :: isfinite( range.first ) || !std :: isfinite( range.second ) )
+        range = { 0.0, 1.0 };
+    if( scaling.scale == ColorScale :: LOG10 )
+    {
+        scaling.hi  =   range.second > 0.0 ? range.second : 1.0;
+        scaling.lo  =   scaling.hi * std :: pow( 10.0, -LOG_DECADES );
+    }
+    else
+    {
+        scaling.lo  =   range.first;
+        scaling.hi  =   range.second > range.first ? range.second : range.first + 1.0;
+    }
+
+    std :: vector<double> bound;
+    for( auto [ key, target ] : { std :: pair<const char*, double*>{ "vmin", &scaling.lo }, { "vmax", &scaling.hi } } )
+    {
+        if( !query.get( key ) )
+            continue;
+
+        if( !parseDoubleList( query.get( key ), bound ) || bound.size() != 1 )
+        {
+            responseCode_ = 400;
+            result[ kError ] = Errors :: INVALID_VRANGE;
+            return false;
+        }
+        *target = bound[ 0 ];
+    }
+
+    if( !( scaling.lo < scaling.hi ) || ( scaling.scale == ColorScale :: LOG10 && !( scaling.lo > 0.0 ) ) )
+    {
+        responseCode_ = 400;
+        result[ kError ] = Errors :: INVALID_VRANGE;
+        return false;
+    }
+    return true;
+}
+
+/*!
+    format = png | jpeg | webp | svg, or when absent the best of png, jpeg and webp the 
+    Accept header takes ( see negotiateFormat ), quality 1 - 100 for jpeg ( default 
+    JPEG_QUALITY ) and webp ( default WEBP_QUALITY ), and levels to contour for svg.
+*/
+bool NetCDFServer :: parseImageFormat( const Request& request, 
+                                       JSONValue& result, 
+                                       ImageFormat& format, 
+                                       int& quality,
+                                       std :: vector<double>& levels )
+{
+    auto query = request.url_params;
+
+    format = negotiateFormat( request.get_header_value( "Accept" ) );
+    if( query.get( "format" ) )
+    {
+        std :: string name = query.get( "format" );
+        if( name == "png" )
+            format = ImageFormat :: PNG;
+        else if( name == "jpeg" || name == "jpg" )
+            format = ImageFormat :: JPEG;
+        else if( name == "webp" && WEBP_AVAILABLE )
+            format = ImageFormat :: WEBP;
+        else if( name == "svg" )
+            format = ImageFormat :: SVG;
+        else
+        {
+            responseCode_ = 400;
+            result[ kError ] = Errors :: INVALID_IMGFMT;
+            return false;
+        }
+    }
+
+    quality = format == ImageFormat :: WEBP ? WEBP_QUALITY : JPEG_QUALITY;
+    if( query.get( "quality" ) )
+    {
+        size_t value = 0;
+        if( !parseIndex( query.get( "quality" ), 101, value ) || value == 0 )
+        {
+            responseCode_ = 400;
+            result[ kError ] = Errors :: INVALID_QUALITY;
+            return false;
+        }
+        quality = static_cast<int>( value );
+    }
+
+    levels.clear();
+    if( query.get( "levels" ) && ( format != ImageFormat :: SVG || !parseDoubleList( query.get( "levels" ), levels ) ) )
+    {
+        responseCode_ = 400;
+        result[ kError ] = Errors :: SVG_LEVELS;
+        return false;
+    }
+    std :: sort( levels.begin(), levels.end() );
+    levels.erase( std :: unique( levels.begin(), levels.end() ), levels.end() );
+    return true;
+}
+
+/*!
+    The format the Accept header ranks highest by q-value. A type listed by name beats 
+    one matched only through a wildcard range, and at equal footing PNG comes first, so 
+    a bare wildcard or no header at all keep getting PNG while listing image/webp gets WebP.
+*/
+ImageFormat NetCDFServer :: negotiateFormat( const std :: string& accept )
+{
+    if( accept.empty() )
+        return ImageFormat :: PNG;
+
+    std :: unordered_map<std :: string, double> weights;
+
+    std :: stringstream list( accept );
+    std :: string       item;
+    while( std :: getline( list, item, ',' ) )
+    {
+        std :: string   type;
+        double          q       =   1.0;
+
+        std :: stringstream parameters( item );
+        std :: string       parameter;
+        for( bool first = true; std :: getline( parameters, parameter, ';' ); first = false )
+        {
+            auto begin  =   parameter.find_first_not_of( " \t" );
+            auto end    =   parameter.find_last_not_of( " \t" );
+            parameter   =   begin == std :: string :: npos ? "" : parameter.substr( begin, end - begin + 1 );
+
+            if( first )
+                type = parameter;
+            else if( parameter.compare( 0, 2, "q=" ) == 0 )
+                q = std :: strtod( parameter.c_str() + 2, nullptr );
+        }
+
+        std :: transform( type.begin(), type.end(), type.begin(), ::tolower );
+        if( !type.empty() )
+            weights[ type ] = q;
+    }
+
+    // ( q, named ) per format, in order of preference on ties
+    std :: vector<std :: pair<ImageFormat, std :: string>> candidates = { { ImageFormat :: PNG, IMAGE_PNG }, { ImageFormat :: JPEG, IMAGE_JPEG } };
+    if( WEBP_AVAILABLE )
+        candidates.insert( candidates.begin() + 1, { ImageFormat :: WEBP, IMAGE_WEBP } );
+
+    ImageFormat                 best        =   ImageFormat :: PNG;
+    std :: pair<double, bool>   bestScore   =   { 0.0, false };
+
+    for( const auto& [ format, type ] : candidates )
+    {
+        std :: pair<double, bool> score = { 0.0, false };
+        if( weights.count( type ) )
+            score = { weights[ type ], true };
+        else if( weights.count( "image/*" ) )
+            score = { weights[ "image/*" ], false };
+        else if( weights.count( "*/*" ) )
+            score = { weights[ "*/*" ], false };
+
+        if( score.first > 0.0 && score > bestScore )
+        {
+            best        =   format;
+            bestScore   =   score;
+        }
+    }
+    return best;
+}
+
+/*!
+    width and / or height in pixels ( 0 = one pixel per cell ), resample = bilinear ( default ) 
+    | nearest. The physical aspect ratio of the grid is kept: a single side derives the other, 
+    and with both the image is the largest one of that aspect fitting inside the box.
+*/
+bool NetCDFServer :: parseImageSize( const Request& request, 
+                                     JSONValue& result, 
+                                     size_t& width, 
+                                     size_t& height, 
+                                     ResampleFilter& filter )
+{
+    auto query = request.url_params;
+
+    std :: string name = query.get( "resample" ) ? query.get( "resample" ) : "bilinear";
+    if( name != "bilinear" && name != "nearest" )
+    {
+        responseCode_ = 400;
+        result[ kError ] = Errors :: INVALID_RESAMP;
+        return false;
+    }
+    filter = name == "nearest" ? ResampleFilter :: NEAREST : ResampleFilter :: BILINEAR;
+
+    for( auto [ key, target ] : { std :: pair<const char*, size_t*>{ "width", &width }, { "height", &height } } )
+    {
+        *target = 0;
+        if( !query.get( key ) )
+            continue;
+
+        std :: string text = query.get( key );
+        if( text.empty() || text.size() > 4 || !std :: all_of( text.begin(), text.end(), ::isdigit ) || 
+            std :: stoul( text ) == 0 || std :: stoul( text ) > MAX_IMAGE_SIDE )
+        {
+            responseCode_ = 400;
+            result[ kError ] = Errors :: INVALID_SIZE;
+            return false;
+        }
+        *target = std :: stoul( text );
+    }
+
+    if( width == 0 && height == 0 )
+        return true;
+
+    double xExtent  =   axisExtent( xCoords_ );
+    double yExtent  =   axisExtent( yCoords_ );
+
+    // pixels per coordinate unit, the same on both axes
+    double scale    =   width == 0  ? height / yExtent :
+                        height == 0 ? width / xExtent :
+                                      std :: min( width / xExtent, height / yExtent );
+
+    auto side = [ & ]( double extent ) { return std :: clamp<size_t>( std :: lround( extent * scale ), 1, MAX_IMAGE_SIDE ); };
+    width   =   side( xExtent );
+    height  =   side( yExtent );
+    return true;
+}
+
+// RGBA rows with the largest y on top, y coordinates increase with the row index
+std :: vector<uint8_t> NetCDFServer :: renderRGBA( const double* plane, 
+                                                   size_t ny, 
+                                                   size_t nx,
+                                                   const Colormap& colormap, 
+                                                   const ColorScaling& scaling )
+{
+    std :: vector<uint8_t> rgba( nx * ny * 4 );
+    for( size_t row = 0; row < ny; row++ )
+        colormap.toRGBA( plane + ( ny - 1 - row ) * nx, nx, scaling, rgba.data() + row * nx * 4 );
+
+    return rgba;
+}
+
+// a whole number below limit, false when text is missing or anything else
+bool NetCDFServer :: parseIndex( const char* text, size_t limit, size_t& value )
+{
+    if( !text || *text == '\0' || std :: strlen( text ) > 9 || !std :: all_of( text, text + std :: strlen( text ), ::isdigit ) )
+        return false;
+
+    value = std :: stoul( text );
+    return value < limit;
+}
+
+/*!
+    A rendered image in format, quality applying to JPEG and WebP. For PNG a 256 entry table 
+    fits the 8 bit palette ( bar one merged pair of neighbouring colors ), which is smaller 
+    and quicker to deflate than RGBA; 4096 entry tables keep their full resolution as RGBA. 
+    See BM_EncodePNG for the numbers.
+*/
+std :: string NetCDFServer :: encodeImage( const std :: vector<uint8_t>& rgba, 
+                                           size_t width, 
+                                           size_t height, 
+                                           const Colormap& colormap,
+                                           ImageFormat format,
+                                           int quality )
+{
+    if( format == ImageFormat :: JPEG )
+        return encodeJPEG( rgba.data(), width, height, quality );
+    if( format == ImageFormat :: WEBP )
+        return encodeWebP( rgba.data(), width, height, quality );
+
+    if( colormap.size() > Colormap :: SMALL_LUT )
+        return encodePNG( rgba.data(), width, height, PNG_RGBA_OPTIONS );
+
+    std :: vector<uint8_t> indices( width * height );
+    colormap.toPaletteIndices( rgba.data(), indices.size(), indices.data() );
+    return encodeIndexedPNG( indices.data(), width, height, colormap.palette(), PNG_PALETTE_OPTIONS );
+}
+
+/*!
+    The plane as SVG, north up: merged cell rectangles in colormap colors, a black contour 
+    path per level, and a colorbar with ticks on the right. Cells keep their physical 
+    size, so non-uniform grids are drawn as they are.
+*/
+void NetCDFServer :: writeSVG( std :: ostream& out,
+                               const double* plane,
+                               const Colormap& colormap, 
+                               const ColorScaling& scaling,
+                               const std :: vector<double>& levels,
+                               double plotWidth,
+                               double plotHeight )
+{
+    size_t                  nx      =   xCoords_.size();
+    size_t                  ny      =   yCoords_.size();
+    std :: vector<double>   xEdges  =   cellEdges( xCoords_ );
+    std :: vector<double>   yEdges  =   cellEdges( yCoords_ );
+
+    double  sx      =   plotWidth / ( xEdges.back() - xEdges.front() );
+    double  sy      =   plotHeight / ( yEdges.back() - yEdges.front() );
+    auto    toX     =   [ & ]( double x ) { return SVG_MARGIN + ( x - xEdges.front() ) * sx; };
+    auto    toY     =   [ & ]( double y ) { return SVG_MARGIN + ( yEdges.back() - y ) * sy; };
+
+    SVGWriter svg( out, 
+                   plotWidth + 3 * SVG_MARGIN + SVG_BAR_WIDTH + SVG_LABEL_WIDTH, 
+                   plotHeight + 2 * SVG_MARGIN );
+
+    std :: vector<double> canvasX( nx + 1 );
+    std :: transform( xEdges.begin(), xEdges.end(), canvasX.begin(), toX );
+
+    // colors are written as the table's packed entries, compared as such when merging
+    std :: vector<uint32_t> colors( nx );
+    for( size_t row = ny; row-- > 0; )
+    {
+        colormap.toRGBA( plane + row * nx, nx, scaling, reinterpret_cast<uint8_t*>( colors.data() ) );
+        svg.cellRow( canvasX, toY( yEdges[ row + 1 ] ), toY( yEdges[ row ] ), colors.data() );
+    }
+    svg.endCells();
+
+    std :: vector<std :: vector<Polygon>> polygonsPerLevel( levels.size() );
+    parallelFor( levels.size(), [ & ]( size_t i )
+    {
+        polygonsPerLevel[ i ] = contourPolygons( plane, xCoords_, yCoords_, levels[ i ] );
+    } );
+
+    for( const auto& polygons : polygonsPerLevel )
+    {
+        std :: vector<Ring> rings;
+        for( const auto& polygon : polygons )
+        {
+            for( const auto& ring : polygon )
+            {
+                Ring canvas;
+                for( const auto& point : ring )
+                    canvas.push_back( { toX( point[ 0 ] ), toY( point[ 1 ] ) } );
+                rings.push_back( std :: move( canvas ) );
             }
-            return result;
-        };
-        concentrationList = to2DJSON( concentrationData_, yData.size(), xData.size() );
-        */
+        }
+        svg.rings( rings, "#000", 1.0 );
+    }
 
-    } 
-    catch( const std :: exception& e )  
+    // value at a position along the bar, 0 at the bottom
+    auto valueAt = [ & ]( double position )
     {
-        result[ kError ] = Errors :: EXTRACT_NCDF + e.what();
+        return scaling.scale == ColorScale :: LOG10 ? scaling.lo * std :: pow( scaling.hi / scaling.lo, position ) 
+                                                    : scaling.lo + position * ( scaling.hi - scaling.lo );
+    };
+    auto colorOf = [ & ]( double value )
+    {
+        uint32_t color;
+        colormap.toRGBA( &value, 1, scaling, reinterpret_cast<uint8_t*>( &color ) );
+        return color;
+    };
+    auto label = []( double value )
+    {
+        char text[ 32 ];
+        std :: snprintf( text, sizeof( text ), "%.3g", value );
+        return std :: string( text );
+    };
+
+    std :: vector<std :: pair<double, uint32_t>>        stops;
+    std :: vector<std :: pair<double, std :: string>>   ticks;
+    bool                                                stepped = true;
+
+    if( scaling.scale == ColorScale :: BREAKS )
+    {
+        // one equal share of the bar per break, labelled with the value it starts at
+        double share = 1.0 / scaling.breaks.size();
+        for( size_t k = 0; k < scaling.breaks.size(); k++ )
+        {
+            stops.emplace_back( k * share, colorOf( scaling.breaks[ k ] ) );
+            ticks.emplace_back( k * share, label( scaling.breaks[ k ] ) );
+        }
     }
-    return result;
+    else
+    {
+        // stepped tables keep their hard edges, smooth ones become a gradient
+        stepped = colormap.stepped();
+        for( int i = 0; i <= 64; i++ )
+        {
+            double      position    =   i / 64.0;
+            uint32_t    color       =   colorOf( valueAt( position ) );
+            if( !stepped || stops.empty() || stops.back().second != color )
+                stops.emplace_back( position, color );
+        }
+
+        if( scaling.scale == ColorScale :: LOG10 )
+        {
+            double lo = std :: log10( scaling.lo );
+            double hi = std :: log10( scaling.hi );
+            for( double decade = std :: ceil( lo ); decade <= hi; decade++ )
+                ticks.emplace_back( ( decade - lo ) / ( hi - lo ), label( std :: pow( 10.0, decade ) ) );
+        }
+        else
+        {
+            for( int i = 0; i <= 4; i++ )
+                ticks.emplace_back( i / 4.0, label( valueAt( i / 4.0 ) ) );
+        }
+    }
+
+    svg.colorbar( plotWidth + 2 * SVG_MARGIN, SVG_MARGIN, SVG_BAR_WIDTH, plotHeight, stops, stepped, ticks );
+    svg.finish();
+}
+
+// comma separated numbers, false if any item fails to parse
+bool NetCDFServer :: parseDoubleList( const char* text, std :: vector<double>& values )
+{
+    std :: stringstream list( text );
+    std :: string       item;
+
+    values.clear();
+    try
+    {
+        while( std :: getline( list, item, ',' ) )
+            values.push_back( std :: stod( item ) );
+    }
+    catch( const std :: exception& e )
+    {
+        return false;
+    }
+    return !values.empty();
+}
+
+// optional bbox=xmin,ymin,xmax,ymax in coordinate units, defaults to the whole plane
+bool NetCDFServer :: parseRegion( const Request& request, JSONValue& result, Region& region )
+{
+    region = Region{ 0, yCoords_.size(), 0, xCoords_.size() };
+
+    auto query = request.url_params;
+    if( !query.get( "bbox" ) )
+        return true;
+
+    std :: vector<double> bounds;
+
+    if( !parseDoubleList( query.get( "bbox" ), bounds ) || 
+        bounds.size() != 4 || bounds[ 0 ] > bounds[ 2 ] || bounds[ 1 ] > bounds[ 3 ] )
+    {
+        responseCode_ = 400;
+        result[ kError ] = Errors :: INVALID_BBOX;
+        return false;
+    }
+
+    // coordinates are monotonically increasing, keep every cell center inside the box
+    auto window = []( const std :: vector<double>& coords, double lo, double hi, size_t& start, size_t& count )
+    {
+        auto first  = std :: lower_bound( coords.begin(), coords.end(), lo );
+        auto last   = std :: upper_bound( coords.begin(), coords.end(), hi );
+        start = first - coords.begin();
+        count = last > first ? last - first : 0;
+    };
+
+    window( xCoords_, bounds[ 0 ], bounds[ 2 ], region.x0, region.nx );
+    window( yCoords_, bounds[ 1 ], bounds[ 3 ], region.y0, region.ny );
+
+    if( region.nx == 0 || region.ny == 0 )
+    {
+        responseCode_ = 400;
+        result[ kError ] = Errors :: INVALID_BBOX;
+        return false;
+    }
+
+    return true;
 }
 
 // this is to give time for the png to be created, check every pollInvervalMs mills
@@ -497,6 +2746,7 @@ bool NetCDFServer :: waitForFile( const std :: string& path,
         {
             return true;
         }
+        CancelToken :: checkCurrent();
         std :: this_thread :: sleep_for( milliseconds( pollIntervalMs ) );
     }
     return false;
@@ -506,13 +2756,17 @@ bool NetCDFServer :: waitForFile( const std :: string& path,
 bool NetCDFServer :: validateRequestParameters( const Request& request, 
                                                 JSONValue& result,
                                                 uint& timeIndex,
-                                                uint& zIndex ) 
+                                                uint& zIndex,
+                                                const std :: vector<std :: string>& optionalParameters ) 
 {
+    TIME_PHASE( Metrics :: VALIDATE );
+
     auto query      { request.url_params };
 
     // extract params and return error if time and height are missing
     if( !query.get( "time" )  || !query.get( "z" ) )  
     {
+        responseCode_ = 400;
         result[ kError ] = Errors :: MISSING_PARMS;
         return false;
     }
@@ -524,7 +2778,7 @@ bool NetCDFServer :: validateRequestParameters( const Request& request,
     }
     catch( const std :: exception& e )
     {
-        responseCode_ = 500;
+        responseCode_ = 400;
         result[ kError ] = Errors :: FAIL_STOI + e.what();
         return false;
     }
@@ -532,25 +2786,34 @@ bool NetCDFServer :: validateRequestParameters( const Request& request,
     // reject request if any other parameters are included
     for( const auto& key : query.keys() )  
     {
-        if ( std :: string( key ) != "time" && std :: string( key ) != "z" )  
+        bool optional = std :: find( optionalParameters.begin(), 
+                                     optionalParameters.end(), 
+                                     std :: string( key ) ) != optionalParameters.end();
+
+        if ( std :: string( key ) != "time" && std :: string( key ) != "z" && !optional )  
         {
+            responseCode_ = 400;
             result[ kError ] = Errors :: INVALID_PARM + std :: string( key )  + ".";
             return false;
         }
     }
 
-    // make sure we're within the bounds of time and depth dimensions
-    size_t timeSize     =   dataFile_.getDim( "time" ).getSize();
-    size_t zSize        =   dataFile_.getDim( "z" ).getSize();
+    // make sure we're within the bounds of time and depth dimensions, as loaded at startup
+    // rather than asked of the NetCDF library, which would need ncMutex_
+    auto   data         =   dataset();
+    size_t timeSize     =   data->timeCoords.size();
+    size_t zSize        =   data->summaryIndex.zSize();
 
-    if( timeIndex < 0 || timeIndex >= timeSize )  
+    if( timeIndex < 0 || timeIndex >= timeSize )
     {
-        result[ kError ] = dataFile_.getDim( "time" ).getName() + Errors :: INDEX_OOR + std :: to_string( timeSize - 1 )  + ".";
+        responseCode_ = 400;
+        result[ kError ] = std :: string( kTime ) + Errors :: INDEX_OOR + std :: to_string( timeSize - 1 )  + ".";
         return false;
     }
-    if( zIndex < 0 || zIndex >= zSize )  
+    if( zIndex < 0 || zIndex >= zSize )
     {
-        result[ kError ] = dataFile_.getDim( "z" ).getName() + Errors :: INDEX_OOR + std :: to_string( zSize - 1 )  + ".";
+        responseCode_ = 400;
+        result[ kError ] = std :: string( kZ ) + Errors :: INDEX_OOR + std :: to_string( zSize - 1 )  + ".";
         return false;
     }
 
@@ -568,12 +2831,470 @@ Response NetCDFServer :: JSONResponse( JSONValue& json, const std :: string& con
     response.code = responseCode_;
     
     // add indentation for readability
+    TIME_PHASE( Metrics :: SERIALIZE );
     response.body = json.dump( 3 ); 
     return response;
 }
 
+/*!
+    time the whole request and count its status against the route. vary names a request 
+    header the response is negotiated on: it goes into the ETag and the Vary header.
+*/
+Response NetCDFServer :: instrumented( size_t route, 
+                                       const Request& request, 
+                                       const std :: string& cacheControl,
+                                       const std :: function<Response()>& handler,
+                                       const std :: string& vary,
+                                       uint64_t queuedMicros )
+{
+    // the total covers the wait for a compute worker too
+    auto start = std :: chrono :: steady_clock :: now() - std :: chrono :: microseconds( queuedMicros );
+
+    // responseCode_ is per thread, do not let an earlier failure on this thread leak into this response
+    responseCode_ = 200;
+    Metrics :: beginRequest( route );
+
+    if( queuedMicros > 0 )
+        Metrics :: recordPhase( Metrics :: QUEUE, queuedMicros );
+
+    std :: string   etag    =   entityTag( request, vary );
+    Response        response;
+
+    // the client already holds this exact response, skip the work entirely
+    if( etagMatches( request.get_header_value( "If-None-Match" ), etag ) )
+    {
+        response.code = 304;
+    }
+    else
+    {
+        response = handler();
+    }
+
+    // only a delivered payload ( or the client's copy of one ) is tagged and cacheable, 
+    // errors keep the no-store the handler gave them
+    bool delivered = response.code == 200 || response.code == 206;
+    if( delivered || response.code == 304 )
+    {
+        response.set_header( "ETag", etag );
+        response.set_header( "Cache-Control", cacheControl );
+    }
+    if( !vary.empty() )
+        response.set_header( "Vary", vary );
+
+    auto elapsed = std :: chrono :: steady_clock :: now() - start;
+    Metrics :: endRequest( response.code, std :: chrono :: duration_cast<std :: chrono :: microseconds>( elapsed ).count() );
+
+#ifdef NETCDF_SERVER_TIMING
+    response.set_header( "Server-Timing", Metrics :: serverTiming() );
+#endif
+
+    return response;
+}
+
+/*!
+    Rough cost of a request, for its compute pool priority: grid values it reads ( a 
+    time range reads every step, dose integrates from step 0 ) plus weighted render 
+    work. Only parsed loosely, the handler still validates. A revalidation that will 
+    get a 304 or a request its route's result cache holds ( keyed by the same ETag ) is 
+    cheap, as are routes that read no grid values; matplot++ figures are always expensive.
+*/
+Cost NetCDFServer :: estimateCost( const Request& request, const std :: string& vary ) const
+{
+    std :: string etag = entityTag( request, vary );
+    if( etagMatches( request.get_header_value( "If-None-Match" ), etag ) )
+        return Cost :: CHEAP;
+
+    bool cached =   ( request.url == "/get-stats"       && statsCache_.find( etag ) ) ||
+                    ( request.url == "/get-contours"    && contourCache_.find( etag ) ) ||
+                    ( request.url == "/get-image"       && imageCache_.find( etag ) ) ||
+                    ( request.url == "/get-animation"   && animationCache_.find( etag ) );
+    if( cached )
+        return Cost :: CHEAP;
+
+    const auto& query = request.url_params;
+    auto number = [ & ]( const char* key, size_t limit, size_t fallback )
+    {
+        size_t value = 0;
+        return parseIndex( query.get( key ), limit, value ) ? value : fallback;
+    };
+
+    size_t  timeSize    =   dataset()->timeCoords.size();
+    size_t  plane       =   yCoords_.size() * xCoords_.size();
+    size_t  time        =   number( kTime, timeSize, 0 );
+    size_t  steps       =   std :: max( time, number( "time_end", timeSize, time ) ) - time + 1;
+    size_t  pixels      =   query.get( "width" ) ? number( "width", MAX_IMAGE_SIDE + 1, 0 ) * number( "height", MAX_IMAGE_SIDE + 1, 0 ) : plane;
+    size_t  cost        =   0;
+
+    if( request.url == "/get-data" || request.url == "/get-raw" || request.url == "/get-stats" || request.url == "/get-exceedance" )
+    {
+        cost = plane * steps;
+    }
+    else if( request.url == "/get-dose" )
+    {
+        size_t z = number( kZ, dataset()->summaryIndex.zSize(), 0 );
+        cost = doseCache_->find( sliceKey( time, z ) ) ? 0 : plane * ( time + 1 );
+    }
+    else if( request.url == "/get-contours" )
+    {
+        cost = plane * RENDER_COST_WEIGHT;
+    }
+    else if( request.url == "/get-image" )
+    {
+        bool native = std :: any_of( IMAGE_PARAMETERS.begin(), IMAGE_PARAMETERS.end(), [ & ]( const std :: string& key ) { return query.get( key ) != nullptr; } ) ||
+                      std :: any_of( IMAGE_FORMAT_PARAMETERS.begin(), IMAGE_FORMAT_PARAMETERS.end(), [ & ]( const std :: string& key ) { return query.get( key ) != nullptr; } );
+        if( !native )
+            return Cost :: EXPENSIVE;
+
+        cost = ( plane + pixels ) * RENDER_COST_WEIGHT;
+    }
+    else if( request.url == "/get-animation" )
+    {
+        size_t from = number( "from", timeSize, 0 );
+        cost = ( std :: max( from, number( "to", timeSize, from ) ) - from + 1 ) * ( plane + pixels ) * RENDER_COST_WEIGHT;
+    }
+
+    return cost < CHEAP_COST ? Cost :: CHEAP : cost < EXPENSIVE_COST ? Cost :: MODERATE : Cost :: EXPENSIVE;
+}
+
+// 504 for work abandoned past its deadline or after its client left ( then it is never sent )
+Response NetCDFServer :: cancelledResponse( const RequestCancelled& cancelled )
+{
+    Metrics :: recordCancelled();
+
+    JSONValue result;
+    result[ kError ]    =   cancelled.reason == RequestCancelled :: DEADLINE ? Errors :: DEADLINE : Errors :: CLIENT_GONE;
+    responseCode_       =   504;
+    return JSONResponse( result, APPLICATION_JSON );
+}
+
+// 503 with Retry-After for load that is shed rather than queued
+Response NetCDFServer :: busyResponse( const std :: string& error )
+{
+    Metrics :: recordShed();
+
+    JSONValue result;
+    result[ kError ]    =   error;
+    responseCode_       =   503;
+
+    Response busy = JSONResponse( result, APPLICATION_JSON );
+    busy.set_header( "Retry-After", std :: to_string( RETRY_AFTER_S ) );
+    return busy;
+}
+
+/*!
+    Run instrumented( ... ) for a route on the compute pool and send the result from the 
+    connection's IO thread, which is free to serve other connections meanwhile. The 
+    request and response belong to the connection, which stays alive until response.end(). 
+    It is queued by estimateCost; when that class is full the request is refused straight 
+    away with 503 and Retry-After, so overload shows up as fast rejections rather than 
+    ever growing latency.
+*/
+void NetCDFServer :: offload( size_t route, 
+                              const Request& request, 
+                              Response& response,
+                              const std :: string& cacheControl,
+                              std :: function<Response()> handler,
+                              const std :: string& vary )
+{
+    auto queuedAt = std :: chrono :: steady_clock :: now();
+    Cost cost     = estimateCost( request, vary );
+
+    auto deadline = deadlinesMs_.find( request.url );
+    auto token    = std :: make_shared<CancelToken>( deadline != deadlinesMs_.end() && deadline->second > 0 ? 
+                                                        queuedAt + std :: chrono :: milliseconds( deadline->second ) : 
+                                                        CancelToken :: Clock :: time_point :: max() );
+
+    // set on the IO thread right before response.end(), after which the response may be gone
+    auto sent     = std :: make_shared<bool>( false );
+
+    bool accepted = computePool_->trySubmit( static_cast<size_t>( cost ), [ this, route, &request, &response, cacheControl, handler = std :: move( handler ), vary, queuedAt, token, sent ]
+    {
+        CancelToken :: Scope scope( token.get() );
+
+        // a failure the handler let through still answers the request, with a 500
+        auto failed = [ this ]( const std :: string& what )
+        {
+            JSONValue result;
+            result[ kError ]    =   Errors :: FAIL_REQUEST + what;
+            responseCode_       =   500;
+            return JSONResponse( result, APPLICATION_JSON );
+        };
+
+        // it may have expired or lost its client while queued, then nothing is read at all
+        auto cancellable = [ & ]
+        {
+            try
+            {
+                CancelToken :: checkCurrent();
+                return handler();
+            }
+            catch( const RequestCancelled& cancelled )
+            {
+                return cancelledResponse( cancelled );
+            }
+            catch( const std :: exception& e )
+            {
+                return failed( e.what() );
+            }
+            catch( ... )
+            {
+                return failed( "unknown exception" );
+            }
+        };
+
+        spooledPath_.clear();
+
+        auto        waited  =   std :: chrono :: steady_clock :: now() - queuedAt;
+        Response    result  =   instrumented( route, request, cacheControl, cancellable, vary, 
+                                              std :: max<int64_t>( 1, std :: chrono :: duration_cast<std :: chrono :: microseconds>( waited ).count() ) );
+
+        std :: string spooled = std :: move( spooledPath_ );
+        spooledPath_.clear();
+
+        // the connection's socket and response are only touched from its own IO thread
+        asio :: post( *request.io_context, [ &response, sent, spooled, result = std :: move( result ) ]() mutable
+        {
+            *sent = true;
+
+            // assigning drops the keep-alive header crow set once the handler returned
+            std :: string connection = response.get_header_value( "Connection" );
+
+            response = std :: move( result );
+            if( !connection.empty() )
+                response.set_header( "Connection", connection );
+            response.end();
+
+            // crow writes a static file out in full within end(), so the spool file is done with
+            if( !spooled.empty() )
+            {
+                std :: error_code error;
+                std :: filesystem :: remove( spooled, error );
+            }
+        } );
+    } );
+
+    if( accepted )
+    {
+        watchConnection( request, response, token, sent );
+        return;
+    }
+
+    response = instrumented( route, request, cacheControl, [ this ]
+    {
+        return busyResponse( Errors :: OVERLOADED );
+    }, vary );
+    response.end();
+}
+
+/*!
+    Every LIVENESS_CHECK_MS until the response is sent, look at the connection from its 
+    own IO thread, the only one that may touch it, and disconnect token once crow 
+    reports it closed. Compute threads only read the token's flag.
+*/
+void NetCDFServer :: watchConnection( const Request& request, 
+                                      Response& response, 
+                                      std :: shared_ptr<CancelToken> token, 
+                                      std :: shared_ptr<bool> sent )
+{
+    auto timer = std :: make_shared<asio :: steady_timer>( *request.io_context, std :: chrono :: milliseconds( LIVENESS_CHECK_MS ) );
+    timer->async_wait( [ this, &request, &response, token, sent, timer ]( const asio :: error_code& error )
+    {
+        if( error || *sent )
+            return;
+
+        if( !response.is_alive() )
+        {
+            token->disconnect();
+            return;
+        }
+        watchConnection( request, response, token, sent );
+    } );
+}
+
+// 64 bit FNV-1a, only needs to be stable and well spread, not cryptographic
+static uint64_t fnv1a( const std :: string& text )
+{
+    uint64_t hash = 14695981039346656037ull;
+    for( unsigned char c : text )
+    {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// hash of the data file's size and mtime, so changing the file invalidates every ETag
+std :: string NetCDFServer :: datasetTag() const
+{
+    uint64_t fileSize = std :: filesystem :: file_size( fileName_ );
+    int64_t  fileTime = std :: filesystem :: last_write_time( fileName_ ).time_since_epoch().count();
+
+    std :: ostringstream tag;
+    tag << std :: hex << fnv1a( std :: to_string( ENTITY_VERSION ) + ':' + std :: to_string( fileSize ) + ':' + std :: to_string( fileTime ) );
+    return tag.str();
+}
+
+/*!
+    Strong ETag: dataset tag plus a hash of the path and the query parameters in
+    sorted order, so the same request spelled with its parameters reordered shares
+    one cache entry. The value of the vary header, if any, is hashed in too.
+*/
+std :: string NetCDFServer :: entityTag( const Request& request, const std :: string& vary ) const
+{
+    std :: string resource = canonicalQuery( request );
+    if( !vary.empty() )
+        resource += '|' + request.get_header_value( vary );
+
+    std :: ostringstream tag;
+    tag << '"' << dataset()->tag << '-' << std :: hex << fnv1a( resource ) << '"';
+    return tag.str();
+}
+
+// path followed by the query parameters in sorted order
+std :: string NetCDFServer :: canonicalQuery( const Request& request )
+{
+    auto keys = request.url_params.keys();
+    std :: sort( keys.begin(), keys.end() );
+
+    std :: string resource = request.url;
+    for( const auto& key : keys )
+    {
+        const char* value = request.url_params.get( key );
+        resource += '&' + key + '=' + ( value ? value : "" );
+    }
+    return resource;
+}
+
+// If-None-Match is "*" or a comma separated list of tags, weak ( W/ ) ones compare by value
+bool NetCDFServer :: etagMatches( const std :: string& ifNoneMatch, const std :: string& etag )
+{
+    std :: stringstream list( ifNoneMatch );
+    std :: string       candidate;
+
+    while( std :: getline( list, candidate, ',' ) )
+    {
+        auto first  = candidate.find_first_not_of( " \t" );
+        auto last   = candidate.find_last_not_of( " \t" );
+        if( first == std :: string :: npos )
+            continue;
+
+        candidate = candidate.substr( first, last - first + 1 );
+        if( candidate.compare( 0, 2, "W/" ) == 0 )
+            candidate.erase( 0, 2 );
+
+        if( candidate == "*" || candidate == etag )
+            return true;
+    }
+    return false;
+}
+
+/*!
+    Crow has no chunked transfer, but it does send static files from disk in small 
+    pieces. So a large body is written to a spool file by writer, holding only what 
+    writer holds, and handed over as a static file. Those pieces are blocking writes on 
+    the connection's IO thread, so a body over SPOOL_MAX_BODY_BYTES is refused with 400 
+    rather than stall that thread's other connections behind one slow client. offload 
+    removes the file once crow has sent it, from spooledPath_; a later sweep catches the 
+    rest. maxBytes bounds what writer writes; it is reserved up front and, when the files 
+    on disk plus every reservation would pass SPOOL_MAX_BYTES, the request gets a 503.
+*/
+Response NetCDFServer :: spooledResponse( const std :: string& extension, uint64_t maxBytes, const std :: function<void( std :: ostream& )>& writer )
+{
+    if( maxBytes > SPOOL_MAX_BODY_BYTES )
+    {
+        JSONValue result;
+        responseCode_       =   400;
+        result[ kError ]    =   Errors :: SPOOL_BODY + std :: to_string( SPOOL_MAX_BODY_BYTES ) + " bytes.";
+        return JSONResponse( result, APPLICATION_JSON );
+    }
+
+    uint64_t spooled    =   sweepSpool();
+    uint64_t reserved   =   spoolReserved_.fetch_add( maxBytes ) + maxBytes;
+
+    // once written the file counts through the next sweep instead
+    struct Reservation
+    {
+        std :: atomic<uint64_t>&    total;
+        uint64_t                    bytes;
+        ~Reservation() { total.fetch_sub( bytes ); }
+    } reservation{ spoolReserved_, maxBytes };
+
+    if( spooled + reserved > SPOOL_MAX_BYTES )
+        return busyResponse( Errors :: SPOOL_FULL );
+
+    std :: string path = generateUniqueFileName( SPOOL_PATH, extension );
+    {
+        std :: ofstream out( path, std :: ios :: binary );
+        if( !out )
+            throw std :: runtime_error( Errors :: FAIL_SPOOL + path );
+
+        try
+        {
+            writer( out );
+        }
+        catch( ... )
+        {
+            out.close();
+            std :: filesystem :: remove( path );
+            throw;
+        }
+
+        out.flush();
+        if( !out )
+        {
+            out.close();
+            std :: filesystem :: remove( path );
+            throw std :: runtime_error( Errors :: FAIL_SPOOL + path );
+        }
+    }
+
+    Response response;
+    response.set_static_file_info_unsafe( path );
+    spooledPath_ = path;
+    return response;
+}
+
+// remove spool files left behind longer than any response takes to send, returns the bytes left
+uint64_t NetCDFServer :: sweepSpool()
+{
+    std :: error_code   error;
+    auto                cutoff  =   std :: filesystem :: file_time_type :: clock :: now() - std :: chrono :: seconds( SPOOL_MAX_AGE_S );
+    uint64_t            bytes   =   0;
+
+    for( const auto& entry : std :: filesystem :: directory_iterator( SPOOL_PATH, error ) )
+    {
+        if( !entry.is_regular_file( error ) )
+            continue;
+
+        if( entry.last_write_time( error ) < cutoff )
+        {
+            std :: filesystem :: remove( entry.path(), error );
+            continue;
+        }
+
+        uintmax_t size = entry.file_size( error );
+        if( !error )
+            bytes += size;
+    }
+    return bytes;
+}
+
+// response object around an already serialized body
+Response NetCDFServer :: bodyResponse( const std :: string& body, const std :: string& contentType ) 
+{
+    Response response;
+    response.set_header( "Content-Type", contentType );
+    response.set_header( "Cache-Control", NO_CACHE_NO_STORE );
+
+    response.code = responseCode_;
+    response.body = body;
+    return response;
+}
+
 // use matplot++ to generate a png 
-JSONValue NetCDFServer :: generateVisual( const std :: vector<std :: vector<double>>& grid, const std :: string& outputPath ) 
+JSONValue NetCDFServer :: generateVisual( const std :: vector<std :: vector<double>>& grid, 
+                                         const std :: string& outputPath,
+                                         const std :: pair<double, double>& colorRange ) 
 {
     JSONValue result;
 
@@ -590,6 +3311,11 @@ JSONValue NetCDFServer :: generateVisual( const std :: vector<std :: vector<doub
 
     // create heatmap 
     imagesc( grid );  
+
+    // gnuplot rejects an empty color range, e.g. a level that is zero everywhere
+    if( colorRange.first < colorRange.second )
+        caxis( { colorRange.first, colorRange.second } );
+
     colorbar();
     title( "Concentration Heatmap" );
 
@@ -0,0 +1,301 @@
+#include "png_encoder.h"
+#include "parallel.h"
+
+#include <cstdlib>
+#include <stdexcept>
+#include <zlib.h>
+
+namespace
+{
+    constexpr unsigned char kSignature[ 8 ] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+
+    void put32( std :: string& out, uint32_t value )
+    {
+        out += static_cast<char>( value >> 24 );
+        out += static_cast<char>( value >> 16 );
+        out += static_cast<char>( value >> 8 );
+        out += static_cast<char>( value );
+    }
+
+    void put16( std :: string& out, uint16_t value )
+    {
+        out += static_cast<char>( value >> 8 );
+        out += static_cast<char>( value );
+    }
+
+    // length, type, data, crc over type + data
+    void writeChunk( std :: string& out, const char* type, const std :: string& data )
+    {
+        put32( out, static_cast<uint32_t>( data.size() ) );
+
+        size_t start = out.size();
+        out.append( type, 4 );
+        out += data;
+
+        uLong crc = crc32( 0, reinterpret_cast<const Bytef*>( out.data() + start ), static_cast<uInt>( out.size() - start ) );
+        put32( out, static_cast<uint32_t>( crc ) );
+    }
+
+    std :: string imageHeader( uint32_t width, uint32_t height, uint8_t colorType )
+    {
+        if( width == 0 || height == 0 )
+            throw std :: invalid_argument( "encodePNG: empty image" );
+
+        std :: string header;
+        put32( header, width );
+        put32( header, height );
+        header += static_cast<char>( 8 );           // bit depth
+        header += static_cast<char>( colorType );   // 6 RGBA, 3 indexed
+        header += std :: string( 3, '\0' );         // deflate, adaptive filtering, no interlace
+        return header;
+    }
+
+    // feed one input span to deflate, growing out as needed
+    void deflateInto( z_stream& stream, std :: string& out, const Bytef* data, size_t size, int flush )
+    {
+        stream.next_in  = const_cast<Bytef*>( data );
+        stream.avail_in = static_cast<uInt>( size );
+
+        do
+        {
+            size_t used = out.size();
+            out.resize( used + 65536 );
+
+            stream.next_out     = reinterpret_cast<Bytef*>( &out[ used ] );
+            stream.avail_out    = 65536;
+
+            int status = deflate( &stream, flush );
+            out.resize( out.size() - stream.avail_out );
+
+            if( status == Z_STREAM_ERROR )
+                throw std :: runtime_error( "encodePNG: deflate failed" );
+            if( status == Z_STREAM_END )
+                break;
+        }
+        while( stream.avail_out == 0 || stream.avail_in > 0 || flush == Z_FINISH );
+    }
+
+    int zlibStrategy( PNGStrategy strategy )
+    {
+        switch( strategy )
+        {
+            case PNGStrategy :: FILTERED:       return Z_FILTERED;
+            case PNGStrategy :: RLE:            return Z_RLE;
+            case PNGStrategy :: HUFFMAN_ONLY:   return Z_HUFFMAN_ONLY;
+            default:                            return Z_DEFAULT_STRATEGY;
+        }
+    }
+
+    inline uint8_t paeth( int a, int b, int c )
+    {
+        int p   =   a + b - c;
+        int pa  =   std :: abs( p - a );
+        int pb  =   std :: abs( p - b );
+        int pc  =   std :: abs( p - c );
+        return static_cast<uint8_t>( pa <= pb && pa <= pc ? a : ( pb <= pc ? b : c ) );
+    }
+
+    /*!
+        row filtered with type into out ( rowBytes long ), prior is the previous unfiltered 
+        row ( nullptr on the first, read as zeros ), bpp the bytes per pixel
+    */
+    void filterRow( PNGFilter type, const uint8_t* row, const uint8_t* prior, size_t rowBytes, size_t bpp, uint8_t* out )
+    {
+        for( size_t i = 0; i < rowBytes; i++ )
+        {
+            int a = i >= bpp ? row[ i - bpp ] : 0;
+            int b = prior ? prior[ i ] : 0;
+            int c = prior && i >= bpp ? prior[ i - bpp ] : 0;
+
+            switch( type )
+            {
+                case PNGFilter :: SUB:      out[ i ] = static_cast<uint8_t>( row[ i ] - a );                    break;
+                case PNGFilter :: UP:       out[ i ] = static_cast<uint8_t>( row[ i ] - b );                    break;
+                case PNGFilter :: AVERAGE:  out[ i ] = static_cast<uint8_t>( row[ i ] - ( ( a + b ) >> 1 ) );   break;
+                case PNGFilter :: PAETH:    out[ i ] = static_cast<uint8_t>( row[ i ] - paeth( a, b, c ) );     break;
+                default:                    out[ i ] = row[ i ];                                                break;
+            }
+        }
+    }
+
+    // residuals as signed bytes, the usual proxy for how well a filtered row deflates
+    uint64_t residualSum( const uint8_t* filtered, size_t rowBytes )
+    {
+        uint64_t sum = 0;
+        for( size_t i = 0; i < rowBytes; i++ )
+            sum += static_cast<uint64_t>( std :: abs( static_cast<int8_t>( filtered[ i ] ) ) );
+        return sum;
+    }
+
+    // zlib stream of the filtered scanlines, the payload of IDAT ( or fdAT )
+    std :: string compressRows( const uint8_t* pixels, uint32_t width, uint32_t height, size_t bpp, const PNGOptions& options )
+    {
+        z_stream stream{};
+        if( deflateInit2( &stream, options.level, Z_DEFLATED, 15, 8, zlibStrategy( options.strategy ) ) != Z_OK )
+            throw std :: runtime_error( "encodePNG: deflateInit failed" );
+
+        constexpr PNGFilter kCandidates[] = { PNGFilter :: NONE, PNGFilter :: SUB, PNGFilter :: UP, PNGFilter :: AVERAGE, PNGFilter :: PAETH };
+
+        std :: string               compressed;
+        size_t                      rowBytes    =   size_t( width ) * bpp;
+        std :: vector<uint8_t>      best( rowBytes + 1 );
+        std :: vector<uint8_t>      trial( rowBytes );
+
+        try
+        {
+            for( uint32_t y = 0; y < height; y++ )
+            {
+                const uint8_t*  row     =   pixels + y * rowBytes;
+                const uint8_t*  prior   =   y > 0 ? row - rowBytes : nullptr;
+                bool            last    =   y + 1 == height;
+
+                // unfiltered rows go to deflate straight from the caller's buffer
+                if( options.filter == PNGFilter :: NONE )
+                {
+                    const Bytef noFilter = 0;
+                    deflateInto( stream, compressed, &noFilter, 1, Z_NO_FLUSH );
+                    deflateInto( stream, compressed, row, rowBytes, last ? Z_FINISH : Z_NO_FLUSH );
+                    continue;
+                }
+
+                if( options.filter != PNGFilter :: ADAPTIVE )
+                {
+                    best[ 0 ] = static_cast<uint8_t>( options.filter );
+                    filterRow( options.filter, row, prior, rowBytes, bpp, best.data() + 1 );
+                }
+                else
+                {
+                    uint64_t bestSum = UINT64_MAX;
+                    for( PNGFilter candidate : kCandidates )
+                    {
+                        filterRow( candidate, row, prior, rowBytes, bpp, trial.data() );
+
+                        uint64_t sum = residualSum( trial.data(), rowBytes );
+                        if( sum < bestSum )
+                        {
+                            bestSum     =   sum;
+                            best[ 0 ]   =   static_cast<uint8_t>( candidate );
+                            std :: copy( trial.begin(), trial.end(), best.begin() + 1 );
+                        }
+                    }
+                }
+                deflateInto( stream, compressed, best.data(), best.size(), last ? Z_FINISH : Z_NO_FLUSH );
+            }
+        }
+        catch( ... )
+        {
+            deflateEnd( &stream );
+            throw;
+        }
+        deflateEnd( &stream );
+        return compressed;
+    }
+}
+
+std :: string encodePNG( const uint8_t* rgba, uint32_t width, uint32_t height, const PNGOptions& options )
+{
+    std :: string header = imageHeader( width, height, 6 );
+
+    std :: string png( reinterpret_cast<const char*>( kSignature ), sizeof( kSignature ) );
+    writeChunk( png, "IHDR", header );
+    writeChunk( png, "IDAT", compressRows( rgba, width, height, 4, options ) );
+    writeChunk( png, "IEND", "" );
+    return png;
+}
+
+std :: string encodeIndexedPNG( const uint8_t* indices, 
+                                uint32_t width, 
+                                uint32_t height, 
+                                const std :: vector<uint32_t>& palette, 
+                                const PNGOptions& options )
+{
+    std :: string header = imageHeader( width, height, 3 );
+    if( palette.empty() || palette.size() > 256 )
+        throw std :: invalid_argument( "encodeIndexedPNG: palette must hold 1 to 256 colors" );
+
+    std :: string colors;
+    std :: string alpha;
+    size_t        translucent = 0;
+    for( size_t i = 0; i < palette.size(); i++ )
+    {
+        colors += static_cast<char>( palette[ i ] & 0xff );
+        colors += static_cast<char>( ( palette[ i ] >> 8 ) & 0xff );
+        colors += static_cast<char>( ( palette[ i ] >> 16 ) & 0xff );
+        alpha  += static_cast<char>( palette[ i ] >> 24 );
+
+        if( ( palette[ i ] >> 24 ) != 0xff )
+            translucent = i + 1;
+    }
+
+    std :: string png( reinterpret_cast<const char*>( kSignature ), sizeof( kSignature ) );
+    writeChunk( png, "IHDR", header );
+    writeChunk( png, "PLTE", colors );
+    if( translucent > 0 )
+        writeChunk( png, "tRNS", alpha.substr( 0, translucent ) );
+    writeChunk( png, "IDAT", compressRows( indices, width, height, 1, options ) );
+    writeChunk( png, "IEND", "" );
+    return png;
+}
+
+/*!
+    IHDR, acTL, then per frame an fcTL followed by its data: IDAT for the first frame 
+    ( so it doubles as the static image ), fdAT after that. fcTL and fdAT share one 
+    sequence number counter.
+*/
+std :: string encodeAPNG( const std :: vector<const uint8_t*>& frames, 
+                          uint32_t width, 
+                          uint32_t height, 
+                          uint16_t delayMs, 
+                          const PNGOptions& options )
+{
+    std :: string header = imageHeader( width, height, 6 );
+    if( frames.empty() )
+        throw std :: invalid_argument( "encodeAPNG: no frames" );
+
+    std :: vector<std :: string> compressed( frames.size() );
+    parallelFor( frames.size(), [ & ]( size_t i )
+    {
+        compressed[ i ] = compressRows( frames[ i ], width, height, 4, options );
+    } );
+
+    std :: string png( reinterpret_cast<const char*>( kSignature ), sizeof( kSignature ) );
+    writeChunk( png, "IHDR", header );
+
+    std :: string animation;
+    put32( animation, static_cast<uint32_t>( frames.size() ) );
+    put32( animation, 0 );                          // loop forever
+    writeChunk( png, "acTL", animation );
+
+    uint32_t sequence = 0;
+    for( size_t i = 0; i < frames.size(); i++ )
+    {
+        std :: string control;
+        put32( control, sequence++ );
+        put32( control, width );
+        put32( control, height );
+        put32( control, 0 );                        // x offset
+        put32( control, 0 );                        // y offset
+        put16( control, delayMs );
+        put16( control, 1000 );
+        control += static_cast<char>( 0 );          // dispose: none
+        control += static_cast<char>( 0 );          // blend: source, the frame replaces everything
+        writeChunk( png, "fcTL", control );
+
+        if( i == 0 )
+        {
+            writeChunk( png, "IDAT", compressed[ i ] );
+            continue;
+        }
+
+        std :: string data;
+        put32( data, sequence++ );
+        data += compressed[ i ];
+        writeChunk( png, "fdAT", data );
+
+        // release as we go, the assembled file is the only copy left
+        std :: string().swap( compressed[ i ] );
+    }
+
+    writeChunk( png, "IEND", "" );
+    return png;
+}
@@ -0,0 +1,245 @@
+#include "reductions.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined( __AVX2__ )
+#include <immintrin.h>
+#endif
+
+// small enough to stay in L1 for the second (centered) loop over a block
+constexpr size_t kBlockSize = 256;
+
+/*++++++++++++++++*
+|  RunningStats   |
+*+++++++++++++++++/
+
+/*!
+    Blocked single pass: plain min/max/sum loop, then a centered loop over the same
+    ( L1 resident ) block for its second moment, merged into the running totals.
+    NaN ( missing, see readConcentration ) is skipped, as in LogHistogram.
+*/
+void RunningStats :: add( const double* values, size_t size )
+{
+    for( size_t offset = 0; offset < size; offset += kBlockSize )
+    {
+        const double*   block   =   values + offset;
+        size_t          n       =   std :: min( kBlockSize, size - offset );
+
+        RunningStats    partial;
+        uint64_t        valid   =   0;
+        uint64_t        nonzero =   0;
+        double          sum     =   0.0;
+        double          lo      =   partial.min;
+        double          hi      =   partial.max;
+
+        // branch-free so the loop vectorizes; NaN compares false everywhere, so it only
+        // has to be kept out of the sum
+        for( size_t i = 0; i < n; i++ )
+        {
+            double  v       =   block[ i ];
+            bool    number  =   v == v;
+            sum     +=  number ? v : 0.0;
+            lo      =   v < lo ? v : lo;
+            hi      =   v > hi ? v : hi;
+            valid   +=  number;
+            nonzero +=  number && v != 0.0;
+        }
+
+        if( valid == 0 )
+            continue;
+
+        double mean = sum / static_cast<double>( valid );
+        double m2   = 0.0;
+
+        for( size_t i = 0; i < n; i++ )
+        {
+            double d = block[ i ] == block[ i ] ? block[ i ] - mean : 0.0;
+            m2 += d * d;
+        }
+
+        partial.count   =   valid;
+        partial.nonzero =   nonzero;
+        partial.sum     =   sum;
+        partial.mean    =   mean;
+        partial.m2      =   m2;
+        partial.min     =   lo;
+        partial.max     =   hi;
+
+        merge( partial );
+    }
+}
+
+// Chan et al. pairwise combination of two sets of moments
+void RunningStats :: merge( const RunningStats& other )
+{
+    if( other.count == 0 )
+        return;
+
+    if( count == 0 )
+    {
+        *this = other;
+        return;
+    }
+
+    double na       =   static_cast<double>( count );
+    double nb       =   static_cast<double>( other.count );
+    double n        =   na + nb;
+    double delta    =   other.mean - mean;
+
+    mean    +=  delta * nb / n;
+    m2      +=  other.m2 + delta * delta * na * nb / n;
+    sum     +=  other.sum;
+    count   +=  other.count;
+    nonzero +=  other.nonzero;
+    min     =   std :: min( min, other.min );
+    max     =   std :: max( max, other.max );
+}
+
+double RunningStats :: variance() const
+{
+    return count > 0 ? m2 / static_cast<double>( count ) : 0.0;
+}
+
+
+/*++++++++++++++++*
+|  LogHistogram   |
+*+++++++++++++++++/
+
+/*!
+    Fixed bucket layout, so histograms from different threads merge by addition.
+*/
+LogHistogram :: LogHistogram() : buckets_( kBucketCount, 0 )
+{
+}
+
+void LogHistogram :: add( const double* values, size_t size )
+{
+    for( size_t i = 0; i < size; i++ )
+    {
+        double v = values[ i ];
+
+        // NaN is neither counted nor bucketed
+        if( v != v )
+            continue;
+
+        total_++;
+
+        if( v <= 0.0 )
+        {
+            nonPositive_++;
+            continue;
+        }
+
+        uint64_t bits;
+        std :: memcpy( &bits, &v, sizeof( bits ) );
+
+        int     exponent    =   static_cast<int>( ( bits >> 52 ) & 0x7ff ) - 1023;
+        size_t  mantissa    =   ( bits >> ( 52 - kSubBucketBits ) ) & ( ( 1u << kSubBucketBits ) - 1 );
+
+        if( exponent < kMinExponent )
+            underflow_++;
+        else if( exponent >= kMaxExponent )
+            overflow_++;
+        else
+            buckets_[ ( size_t( exponent - kMinExponent ) << kSubBucketBits ) | mantissa ]++;
+    }
+}
+
+void LogHistogram :: merge( const LogHistogram& other )
+{
+    for( size_t i = 0; i < kBucketCount; i++ )
+        buckets_[ i ] += other.buckets_[ i ];
+
+    nonPositive_    +=  other.nonPositive_;
+    underflow_      +=  other.underflow_;
+    overflow_       +=  other.overflow_;
+    total_          +=  other.total_;
+}
+
+double LogHistogram :: bucketLowerBound( size_t index )
+{
+    int     exponent    =   static_cast<int>( index >> kSubBucketBits ) + kMinExponent;
+    double  mantissa    =   1.0 + static_cast<double>( index & ( ( 1u << kSubBucketBits ) - 1 ) ) / ( 1u << kSubBucketBits );
+
+    return std :: ldexp( mantissa, exponent );
+}
+
+double LogHistogram :: quantile( double q, double lo, double hi ) const
+{
+    if( total_ == 0 )
+        return std :: nan( "" );
+
+    q = std :: clamp( q, 0.0, 1.0 );
+
+    // zero-based fractional rank of the requested quantile
+    double rank = q * static_cast<double>( total_ - 1 );
+
+    auto clamped = [ & ]( double v ) { return std :: clamp( v, lo, hi ); };
+
+    double seen = static_cast<double>( nonPositive_ );
+    if( rank < seen )
+        return clamped( std :: min( lo, 0.0 ) );
+
+    seen += static_cast<double>( underflow_ );
+    if( rank < seen )
+        return clamped( std :: ldexp( 1.0, kMinExponent ) );
+
+    for( size_t i = 0; i < kBucketCount; i++ )
+    {
+        if( buckets_[ i ] == 0 )
+            continue;
+
+        double inBucket = static_cast<double>( buckets_[ i ] );
+        if( rank < seen + inBucket )
+        {
+            // interpolate linearly inside the bucket
+            double lower    =   bucketLowerBound( i );
+            double upper    =   i + 1 < kBucketCount ? bucketLowerBound( i + 1 ) : lower * 2.0;
+            double fraction =   std :: clamp( ( rank - seen + 0.5 ) / inBucket, 0.0, 1.0 );
+
+            return clamped( lower + fraction * ( upper - lower ) );
+        }
+        seen += inBucket;
+    }
+
+    return hi;
+}
+
+
+/*++++++++++++++++*
+|  thresholdMask  |
+*+++++++++++++++++/
+
+/*!
+    One 64 bit word per 64 values, so each word is built from registers and popcounted once.
+*/
+uint64_t thresholdMask( const double* values, size_t size, double level, uint64_t* mask )
+{
+    uint64_t    count   =   0;
+    size_t      words   =   ( size + 63 ) / 64;
+
+    for( size_t w = 0; w < words; w++ )
+    {
+        const double*   block   =   values + w * 64;
+        size_t          n       =   std :: min<size_t>( 64, size - w * 64 );
+        uint64_t        word    =   0;
+        size_t          i       =   0;
+
+#if defined( __AVX2__ )
+        __m256d threshold = _mm256_set1_pd( level );
+        for( ; i + 4 <= n; i += 4 )
+        {
+            __m256d above = _mm256_cmp_pd( _mm256_loadu_pd( block + i ), threshold, _CMP_GE_OQ );
+            word |= uint64_t( _mm256_movemask_pd( above ) ) << i;
+        }
+#endif
+        for( ; i < n; i++ )
+            word |= uint64_t( block[ i ] >= level ) << i;
+
+        mask[ w ]   =   word;
+        count       +=  __builtin_popcountll( word );
+    }
+    return count;
+}
@@ -0,0 +1,128 @@
+#include "resample.h"
+
+#include <algorithm>
+#include <limits>
+
+double axisExtent( const std :: vector<double>& coords )
+{
+    size_t n = coords.size();
+    if( n < 2 )
+        return 1.0;
+
+    return ( coords[ n - 1 ] - coords[ 0 ] ) + 0.5 * ( coords[ 1 ] - coords[ 0 ] ) + 0.5 * ( coords[ n - 1 ] - coords[ n - 2 ] );
+}
+
+std :: vector<double> cellEdges( const std :: vector<double>& coords )
+{
+    size_t                  n = coords.size();
+    std :: vector<double>   edges( n + 1, 0.0 );
+
+    if( n < 2 )
+    {
+        double center = n == 1 ? coords[ 0 ] : 0.0;
+        return { center - 0.5, center + 0.5 };
+    }
+
+    edges[ 0 ]  =   coords[ 0 ] - 0.5 * ( coords[ 1 ] - coords[ 0 ] );
+    edges[ n ]  =   coords[ n - 1 ] + 0.5 * ( coords[ n - 1 ] - coords[ n - 2 ] );
+    for( size_t i = 1; i < n; i++ )
+        edges[ i ] = 0.5 * ( coords[ i - 1 ] + coords[ i ] );
+
+    return edges;
+}
+
+ResampleAxis resampleAxis( const std :: vector<double>& coords, size_t size, ResampleFilter filter )
+{
+    ResampleAxis axis;
+    axis.first.assign( size, 0 );
+    axis.second.assign( size, 0 );
+    axis.weight.assign( size, 0.0 );
+
+    size_t n = coords.size();
+    if( n < 2 )
+        return axis;
+
+    double lo       =   coords[ 0 ] - 0.5 * ( coords[ 1 ] - coords[ 0 ] );
+    double step     =   axisExtent( coords ) / static_cast<double>( size );
+    size_t k        =   0;
+
+    for( size_t j = 0; j < size; j++ )
+    {
+        // pixel center, increasing, so the bracketing cell only ever moves forward
+        double p = lo + ( static_cast<double>( j ) + 0.5 ) * step;
+        while( k + 2 < n && coords[ k + 1 ] <= p )
+            k++;
+
+        double f = std :: clamp( ( p - coords[ k ] ) / ( coords[ k + 1 ] - coords[ k ] ), 0.0, 1.0 );
+
+        if( filter == ResampleFilter :: NEAREST )
+        {
+            axis.first[ j ]     =   static_cast<uint32_t>( f < 0.5 ? k : k + 1 );
+            axis.second[ j ]    =   axis.first[ j ];
+        }
+        else
+        {
+            axis.first[ j ]     =   static_cast<uint32_t>( k );
+            axis.second[ j ]    =   static_cast<uint32_t>( k + 1 );
+            axis.weight[ j ]    =   f;
+        }
+    }
+    return axis;
+}
+
+void resample( const double* plane, size_t nx, const ResampleAxis& rows, const ResampleAxis& cols, double* out )
+{
+    const size_t    width   =   cols.first.size();
+    const size_t    height  =   rows.first.size();
+    const size_t    none    =   std :: numeric_limits<size_t> :: max();
+
+    const uint32_t* first   =   cols.first.data();
+    const uint32_t* second  =   cols.second.data();
+    const double*   weight  =   cols.weight.data();
+
+    // horizontally resampled source rows, tagged with the row they came from
+    std :: vector<double>   cache[ 2 ]  =   { std :: vector<double>( width ), std :: vector<double>( width ) };
+    size_t                  cached[ 2 ] =   { none, none };
+
+    auto horizontal = [ & ]( size_t row, double* dst )
+    {
+        const double* src = plane + row * nx;
+        for( size_t j = 0; j < width; j++ )
+        {
+            double a = src[ first[ j ] ];
+            dst[ j ] = a + weight[ j ] * ( src[ second[ j ] ] - a );
+        }
+    };
+
+    // slot holding source row, filling the one not needed by keep
+    auto fetch = [ & ]( size_t row, size_t keep ) -> const double*
+    {
+        for( size_t s = 0; s < 2; s++ )
+        {
+            if( cached[ s ] == row )
+                return cache[ s ].data();
+        }
+
+        size_t slot = cached[ 0 ] == keep ? 1 : 0;
+        horizontal( row, cache[ slot ].data() );
+        cached[ slot ] = row;
+        return cache[ slot ].data();
+    };
+
+    for( size_t i = 0; i < height; i++ )
+    {
+        const double*   a   =   fetch( rows.first[ i ], none );
+        const double*   b   =   fetch( rows.second[ i ], rows.first[ i ] );
+        double          w   =   rows.weight[ i ];
+        double*         dst =   out + i * width;
+
+        if( w == 0.0 )
+        {
+            std :: copy( a, a + width, dst );
+            continue;
+        }
+
+        for( size_t j = 0; j < width; j++ )
+            dst[ j ] = a[ j ] + w * ( b[ j ] - a[ j ] );
+    }
+}
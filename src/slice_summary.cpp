@@ -0,0 +1,174 @@
+#include "slice_summary.h"
+#include "parallel.h"
+#include "reductions.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+
+// first token of the sidecar, bump the version when the layout changes
+constexpr char kSidecarMagic[]      =   "netcdf-server-summary";
+constexpr int  kSidecarVersion      =   1;
+
+std :: string SliceSummaryIndex :: sidecarPath( const std :: string& dataPath )
+{
+    return dataPath + ".summary";
+}
+
+const SliceSummary& SliceSummaryIndex :: at( size_t timeIndex, size_t zIndex ) const
+{
+    return slices_.at( timeIndex * zSize_ + zIndex );
+}
+
+std :: pair<double, double> SliceSummaryIndex :: range( size_t zIndex ) const
+{
+    double lo = std :: numeric_limits<double> :: infinity();
+    double hi = -std :: numeric_limits<double> :: infinity();
+
+    for( size_t t = 0; t < timeSize_; t++ )
+    {
+        lo = std :: min( lo, at( t, zIndex ).min );
+        hi = std :: max( hi, at( t, zIndex ).max );
+    }
+    return { lo, hi };
+}
+
+/*!
+    Identify the data file by size and mtime; a mismatch or unreadable sidecar 
+    rebuilds the table with one task per slice. Failing to write the sidecar 
+    ( read only data directory ) only costs the next startup a rebuild.
+*/
+void SliceSummaryIndex :: loadOrBuild( const std :: string& dataPath,
+                                       size_t timeSize,
+                                       size_t zSize,
+                                       size_t planeSize,
+                                       const PlaneReader& reader,
+                                       const SliceSummaryIndex* previous )
+{
+    uint64_t fileSize = std :: filesystem :: file_size( dataPath );
+    int64_t  fileTime = std :: filesystem :: last_write_time( dataPath ).time_since_epoch().count();
+
+    timeSize_   =   timeSize;
+    zSize_      =   zSize;
+
+    std :: string path = sidecarPath( dataPath );
+    if( load( path, fileSize, fileTime ) )
+        return;
+
+    slices_.assign( timeSize * zSize, SliceSummary{} );
+
+    // appended steps leave the earlier slices as they were
+    size_t reused = 0;
+    if( previous && previous->zSize_ == zSize && previous->timeSize_ <= timeSize )
+    {
+        reused = previous->slices_.size();
+        std :: copy( previous->slices_.begin(), previous->slices_.end(), slices_.begin() );
+    }
+
+    parallelFor( slices_.size() - reused, [ & ]( size_t task )
+    {
+        size_t                  i   =   reused + task;
+        std :: vector<double>   values( planeSize );
+        reader( i / zSize, i % zSize, values.data() );
+
+        RunningStats stats;
+        stats.add( values.data(), values.size() );
+
+        slices_[ i ] = SliceSummary{ stats.min, stats.max, stats.mean, stats.nonzero };
+    } );
+
+    try
+    {
+        save( path, fileSize, fileTime );
+    }
+    catch( const std :: exception& e )
+    {
+        std :: cerr << "SliceSummaryIndex :: loadOrBuild: could not write " << path << ": " << e.what() << std :: endl;
+    }
+}
+
+// non-finite values are written as nan, inf and -inf, which operator>> cannot read back but strtod can
+static void writeNumber( std :: ostream& out, double value )
+{
+    if( std :: isnan( value ) )
+        out << "nan";
+    else if( std :: isinf( value ) )
+        out << ( value > 0 ? "inf" : "-inf" );
+    else
+        out << value;
+}
+
+static bool readNumber( std :: istream& in, double& value )
+{
+    std :: string token;
+    if( !( in >> token ) )
+        return false;
+
+    char* end = nullptr;
+    value = std :: strtod( token.c_str(), &end );
+    return end == token.c_str() + token.size();
+}
+
+bool SliceSummaryIndex :: load( const std :: string& path, uint64_t fileSize, int64_t fileTime )
+{
+    std :: ifstream in( path );
+    if( !in )
+        return false;
+
+    std :: string   magic;
+    int             version     =   0;
+    uint64_t        size        =   0;
+    int64_t         time        =   0;
+    size_t          timeSize    =   0;
+    size_t          zSize       =   0;
+
+    in >> magic >> version >> size >> time >> timeSize >> zSize;
+
+    if( !in || magic != kSidecarMagic || version != kSidecarVersion || 
+        size != fileSize || time != fileTime || timeSize != timeSize_ || zSize != zSize_ )
+        return false;
+
+    std :: vector<SliceSummary> slices( timeSize * zSize );
+    for( auto& slice : slices )
+    {
+        if( !readNumber( in, slice.min ) || !readNumber( in, slice.max ) || !readNumber( in, slice.mean ) || !( in >> slice.nonzero ) )
+            return false;
+    }
+
+    slices_ = std :: move( slices );
+    return true;
+}
+
+// write to a temporary name and rename, so a crash never leaves a torn sidecar
+void SliceSummaryIndex :: save( const std :: string& path, uint64_t fileSize, int64_t fileTime ) const
+{
+    std :: string temporary = path + ".tmp";
+    {
+        std :: ofstream out( temporary, std :: ios :: trunc );
+        if( !out )
+            throw std :: runtime_error( "failed to open for writing" );
+
+        out << kSidecarMagic << ' ' << kSidecarVersion << ' ' << fileSize << ' ' << fileTime << ' ' 
+            << timeSize_ << ' ' << zSize_ << '\n';
+
+        out << std :: setprecision( std :: numeric_limits<double> :: max_digits10 );
+        for( const auto& slice : slices_ )
+        {
+            writeNumber( out, slice.min );
+            out << ' ';
+            writeNumber( out, slice.max );
+            out << ' ';
+            writeNumber( out, slice.mean );
+            out << ' ' << slice.nonzero << '\n';
+        }
+
+        if( !out )
+            throw std :: runtime_error( "write failed" );
+    }
+    std :: filesystem :: rename( temporary, path );
+}
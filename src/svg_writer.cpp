@@ -0,0 +1,171 @@
+#include "svg_writer.h"
+
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+    // at most two decimals, trailing zeros dropped, canvas units are roughly pixels
+    std :: string number( double value )
+    {
+        char text[ 32 ];
+        std :: snprintf( text, sizeof( text ), "%.2f", std :: abs( value ) < 0.005 ? 0.0 : value );
+
+        std :: string result( text );
+        while( result.back() == '0' )
+            result.pop_back();
+        if( result.back() == '.' )
+            result.pop_back();
+        return result;
+    }
+
+    // for attribute values and text content
+    std :: string escape( const std :: string& text )
+    {
+        std :: string result;
+        for( char c : text )
+        {
+            switch( c )
+            {
+                case '&':   result += "&amp;";  break;
+                case '<':   result += "&lt;";   break;
+                case '>':   result += "&gt;";   break;
+                case '"':   result += "&quot;"; break;
+                default:    result += c;        break;
+            }
+        }
+        return result;
+    }
+}
+
+std :: string svgColor( uint32_t color )
+{
+    char text[ 8 ];
+    std :: snprintf( text, sizeof( text ), "#%02x%02x%02x", color & 0xff, ( color >> 8 ) & 0xff, ( color >> 16 ) & 0xff );
+    return text;
+}
+
+SVGWriter :: SVGWriter( std :: ostream& out, double width, double height ) : out_( out )
+{
+    out_    << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+            << "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"" << number( width ) << "\" height=\"" << number( height )
+            << "\" viewBox=\"0 0 " << number( width ) << ' ' << number( height ) << "\" shape-rendering=\"crispEdges\">\n";
+}
+
+void SVGWriter :: cellRow( const std :: vector<double>& xEdges, double top, double bottom, const uint32_t* colors )
+{
+    size_t nx = xEdges.size() - 1;
+    size_t o  = 0;
+
+    next_.clear();
+    for( size_t first = 0; first < nx; )
+    {
+        size_t last = first + 1;
+        while( last < nx && colors[ last ] == colors[ first ] )
+            last++;
+
+        if( ( colors[ first ] >> 24 ) != 0 )
+        {
+            // open blocks are ordered and disjoint, anything ending before this run is done
+            while( o < open_.size() && open_[ o ].last <= first )
+                closeBlock( open_[ o++ ] );
+
+            if( o < open_.size() && open_[ o ].first == first && open_[ o ].last == last && open_[ o ].color == colors[ first ] )
+            {
+                Block block     =   open_[ o++ ];
+                block.bottom    =   bottom;
+                next_.push_back( block );
+            }
+            else
+            {
+                next_.push_back( { first, last, colors[ first ], xEdges[ first ], xEdges[ last ], top, bottom } );
+            }
+        }
+        first = last;
+    }
+
+    while( o < open_.size() )
+        closeBlock( open_[ o++ ] );
+
+    open_.swap( next_ );
+}
+
+void SVGWriter :: closeBlock( const Block& block )
+{
+    out_    << "<rect x=\"" << number( block.x0 ) << "\" y=\"" << number( block.top )
+            << "\" width=\"" << number( block.x1 - block.x0 ) << "\" height=\"" << number( block.bottom - block.top )
+            << "\" fill=\"" << svgColor( block.color ) << "\"/>\n";
+}
+
+void SVGWriter :: rings( const std :: vector<Ring>& rings, const std :: string& stroke, double strokeWidth )
+{
+    if( rings.empty() )
+        return;
+
+    out_ << "<path fill=\"none\" stroke=\"" << escape( stroke ) << "\" stroke-width=\"" << number( strokeWidth ) << "\" d=\"";
+    for( const auto& ring : rings )
+    {
+        // the closing point repeats the first one, Z draws that segment
+        for( size_t i = 0; i + 1 < ring.size(); i++ )
+            out_ << ( i == 0 ? 'M' : 'L' ) << number( ring[ i ][ 0 ] ) << ' ' << number( ring[ i ][ 1 ] );
+        out_ << 'Z';
+    }
+    out_ << "\"/>\n";
+}
+
+void SVGWriter :: colorbar( double x, double y, double width, double height,
+                            const std :: vector<std :: pair<double, uint32_t>>& stops,
+                            bool stepped,
+                            const std :: vector<std :: pair<double, std :: string>>& ticks )
+{
+    auto yAt = [ & ]( double position ) { return y + ( 1.0 - position ) * height; };
+
+    if( stepped )
+    {
+        for( size_t i = 0; i < stops.size(); i++ )
+        {
+            double upper = i + 1 < stops.size() ? stops[ i + 1 ].first : 1.0;
+            out_    << "<rect x=\"" << number( x ) << "\" y=\"" << number( yAt( upper ) )
+                    << "\" width=\"" << number( width ) << "\" height=\"" << number( ( upper - stops[ i ].first ) * height )
+                    << "\" fill=\"" << svgColor( stops[ i ].second ) << "\"/>\n";
+        }
+    }
+    else
+    {
+        std :: string id = "colorbar" + std :: to_string( gradients_++ );
+
+        out_ << "<defs><linearGradient id=\"" << id << "\" x1=\"0\" y1=\"1\" x2=\"0\" y2=\"0\">";
+        for( const auto& [ position, color ] : stops )
+            out_ << "<stop offset=\"" << number( position * 100.0 ) << "%\" stop-color=\"" << svgColor( color ) << "\"/>";
+        out_ << "</linearGradient></defs>\n";
+
+        out_    << "<rect x=\"" << number( x ) << "\" y=\"" << number( y ) << "\" width=\"" << number( width )
+                << "\" height=\"" << number( height ) << "\" fill=\"url(#" << id << ")\"/>\n";
+    }
+
+    out_    << "<rect x=\"" << number( x ) << "\" y=\"" << number( y ) << "\" width=\"" << number( width )
+            << "\" height=\"" << number( height ) << "\" fill=\"none\" stroke=\"#000\" stroke-width=\"1\"/>\n";
+
+    out_ << "<g font-family=\"sans-serif\" font-size=\"11\" dominant-baseline=\"middle\">\n";
+    for( const auto& [ position, label ] : ticks )
+    {
+        double ty = yAt( position );
+        out_    << "<line x1=\"" << number( x + width ) << "\" y1=\"" << number( ty ) << "\" x2=\"" << number( x + width + 4 )
+                << "\" y2=\"" << number( ty ) << "\" stroke=\"#000\"/>"
+                << "<text x=\"" << number( x + width + 6 ) << "\" y=\"" << number( ty ) << "\">" << escape( label ) << "</text>\n";
+    }
+    out_ << "</g>\n";
+}
+
+void SVGWriter :: endCells()
+{
+    for( const auto& block : open_ )
+        closeBlock( block );
+    open_.clear();
+}
+
+void SVGWriter :: finish()
+{
+    endCells();
+    out_ << "</svg>\n";
+}
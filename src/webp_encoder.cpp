@@ -0,0 +1,35 @@
+#include "webp_encoder.h"
+
+#include <stdexcept>
+
+#ifdef NETCDF_SERVER_HAVE_WEBP
+#include <webp/encode.h>
+#endif
+
+std :: string encodeWebP( const uint8_t* rgba, uint32_t width, uint32_t height, int quality )
+{
+#ifdef NETCDF_SERVER_HAVE_WEBP
+    if( width == 0 || height == 0 || width > WEBP_MAX_DIMENSION || height > WEBP_MAX_DIMENSION )
+        throw std :: invalid_argument( "encodeWebP: image size out of range" );
+
+    uint8_t*    output  =   nullptr;
+    size_t      size    =   WebPEncodeRGBA( rgba, 
+                                            static_cast<int>( width ), 
+                                            static_cast<int>( height ), 
+                                            static_cast<int>( width * 4 ), 
+                                            static_cast<float>( quality ), 
+                                            &output );
+    if( size == 0 )
+        throw std :: runtime_error( "encodeWebP: WebPEncodeRGBA failed" );
+
+    std :: string webp( reinterpret_cast<const char*>( output ), size );
+    WebPFree( output );
+    return webp;
+#else
+    static_cast<void>( rgba );
+    static_cast<void>( width );
+    static_cast<void>( height );
+    static_cast<void>( quality );
+    throw std :: runtime_error( "encodeWebP: built without libwebp" );
+#endif
+}
@@ -0,0 +1,270 @@
+/*!
+    loadgen: end-to-end throughput harness. Starts NetCDFServer in-process on an
+    ephemeral port, drives a weighted mix of /get-info, /get-data and /get-image over
+    N concurrent keep-alive connections for a fixed duration, then reports requests/sec
+    and p50/p99/p999 latency overall and per route.
+
+    usage: loadgen [--data FILE] [--threads N] [--compute N] [--connections N] 
+                   [--duration SECONDS] [--mix info:1,data:8,image:1]
+
+    --threads is the server's IO concurrency and --compute its compute pool size ( 0 = the
+    server defaults ), so the same mix can be swept across thread counts to see how the 
+    server scales. Requests shed with 503 under overload count as errors.
+*/
+
+#include "netcdf_server.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std :: chrono :: steady_clock;
+
+struct Options
+{
+    std :: string                           data        =   "data/concentration.timeseries.nc";
+    uint                                    threads     =   0;
+    uint                                    compute     =   0;
+    uint                                    connections =   16;
+    double                                  duration    =   10.0;
+    std :: vector<std :: pair<std :: string, double>>   mix = { { "info", 1 }, { "data", 8 }, { "image", 1 } };
+};
+
+// one completed request
+struct Sample
+{
+    size_t      route;
+    uint32_t    micros;
+    bool        ok;
+};
+
+static Options parseOptions( int argc, char** argv )
+{
+    Options options;
+
+    for( int i = 1; i + 1 < argc; i += 2 )
+    {
+        std :: string flag  = argv[ i ];
+        std :: string value = argv[ i + 1 ];
+
+        if( flag == "--data" )              options.data        = value;
+        else if( flag == "--threads" )      options.threads     = std :: stoul( value );
+        else if( flag == "--compute" )      options.compute     = std :: stoul( value );
+        else if( flag == "--connections" )  options.connections = std :: stoul( value );
+        else if( flag == "--duration" )     options.duration    = std :: stod( value );
+        else if( flag == "--mix" )
+        {
+            options.mix.clear();
+
+            std :: stringstream list( value );
+            std :: string       item;
+            while( std :: getline( list, item, ',' ) )
+            {
+                auto colon = item.find( ':' );
+                options.mix.emplace_back( item.substr( 0, colon ), colon == std :: string :: npos ? 1.0 : std :: stod( item.substr( colon + 1 ) ) );
+            }
+        }
+        else
+        {
+            throw std :: invalid_argument( "unknown option " + flag );
+        }
+    }
+    return options;
+}
+
+/*!
+    Minimal blocking HTTP/1.1 client over one keep-alive connection.
+    Crow always sends Content-Length, so responses are framed by it.
+*/
+class Connection
+{
+    public:
+        Connection( asio :: io_context& io, uint16_t port ) : socket_( io )
+        {
+            socket_.connect( asio :: ip :: tcp :: endpoint( asio :: ip :: make_address( "127.0.0.1" ), port ) );
+            socket_.set_option( asio :: ip :: tcp :: no_delay( true ) );
+        }
+
+        // returns the status code, body in body
+        int get( const std :: string& target, std :: string& body )
+        {
+            std :: string request = "GET " + target + " HTTP/1.1\r\nHost: localhost\r\nConnection: keep-alive\r\n\r\n";
+            asio :: write( socket_, asio :: buffer( request ) );
+
+            size_t headerEnd = asio :: read_until( socket_, buffer_, "\r\n\r\n" );
+
+            std :: string headers( asio :: buffers_begin( buffer_.data() ), asio :: buffers_begin( buffer_.data() ) + headerEnd );
+            buffer_.consume( headerEnd );
+
+            int status = std :: stoi( headers.substr( headers.find( ' ' ) + 1, 3 ) );
+
+            size_t  length = 0;
+            auto    lower  = headers;
+            std :: transform( lower.begin(), lower.end(), lower.begin(), ::tolower );
+            auto    field  = lower.find( "content-length:" );
+            if( field != std :: string :: npos )
+                length = std :: stoul( headers.substr( field + 15 ) );
+
+            if( buffer_.size() < length )
+                asio :: read( socket_, buffer_, asio :: transfer_exactly( length - buffer_.size() ) );
+
+            body.assign( asio :: buffers_begin( buffer_.data() ), asio :: buffers_begin( buffer_.data() ) + length );
+            buffer_.consume( length );
+
+            return status;
+        }
+
+    private:
+        asio :: ip :: tcp :: socket socket_;
+        asio :: streambuf           buffer_;
+};
+
+static uint32_t percentile( std :: vector<uint32_t>& sorted, double q )
+{
+    if( sorted.empty() )
+        return 0;
+    return sorted[ std :: min( sorted.size() - 1, static_cast<size_t>( q * sorted.size() ) ) ];
+}
+
+static void report( const std :: string& name, std :: vector<uint32_t> latencies, size_t errors, double seconds )
+{
+    std :: sort( latencies.begin(), latencies.end() );
+
+    std :: printf( "%-12s %10zu %8zu %12.1f %10.3f %10.3f %10.3f\n",
+                   name.c_str(),
+                   latencies.size(),
+                   errors,
+                   latencies.size() / seconds,
+                   percentile( latencies, 0.50 ) * 1e-3,
+                   percentile( latencies, 0.99 ) * 1e-3,
+                   percentile( latencies, 0.999 ) * 1e-3 );
+}
+
+int main( int argc, char** argv )
+{
+    Options options;
+    try
+    {
+        options = parseOptions( argc, argv );
+    }
+    catch( const std :: exception& e )
+    {
+        std :: cerr << "loadgen: " << e.what() << std :: endl;
+        return 1;
+    }
+
+    // per request logging would dominate the measurement
+    crow :: logger :: setLogLevel( crow :: LogLevel :: Warning );
+
+    // every connection comes from the same address, per client limits would measure themselves
+    NetCDFServer    server( options.data );
+    server.setRateLimit( 0, 0, 0 );
+    auto            done = server.runAsync( 0, options.threads, options.compute );
+    uint16_t        port = server.port();
+
+    // dimension sizes from /get-info, to pick valid random indices
+    size_t timeSize = 1;
+    size_t zSize    = 1;
+    {
+        asio :: io_context  io;
+        Connection          connection( io, port );
+        std :: string       body;
+
+        connection.get( "/get-info", body );
+        auto info = crow :: json :: load( body );
+        timeSize  = info[ "dimensions" ][ kTime ].u();
+        zSize     = info[ "dimensions" ][ kZ ].u();
+    }
+
+    std :: vector<std :: string>    routes;
+    std :: vector<double>           weights;
+    for( const auto& [ name, weight ] : options.mix )
+    {
+        routes.push_back( "/get-" + name );
+        weights.push_back( weight );
+    }
+
+    std :: vector<std :: vector<Sample>>    samples( options.connections );
+    std :: atomic<bool>                     failed{ false };
+    auto                                    start       =   Clock :: now();
+    auto                                    deadline    =   start + std :: chrono :: duration_cast<Clock :: duration>( std :: chrono :: duration<double>( options.duration ) );
+
+    std :: vector<std :: thread> clients;
+    for( uint c = 0; c < options.connections; c++ )
+    {
+        clients.emplace_back( [ &, c ]
+        {
+            try
+            {
+                asio :: io_context  io;
+                Connection          connection( io, port );
+                std :: mt19937      random( c );
+                std :: string       body;
+
+                std :: discrete_distribution<size_t>        pickRoute( weights.begin(), weights.end() );
+                std :: uniform_int_distribution<size_t>     pickTime( 0, timeSize - 1 );
+                std :: uniform_int_distribution<size_t>     pickZ( 0, zSize - 1 );
+
+                while( Clock :: now() < deadline )
+                {
+                    size_t      route   =   pickRoute( random );
+                    std :: string target = routes[ route ];
+                    if( target != "/get-info" )
+                        target += "?time=" + std :: to_string( pickTime( random ) ) + "&z=" + std :: to_string( pickZ( random ) );
+
+                    auto    sent    =   Clock :: now();
+                    int     status  =   connection.get( target, body );
+                    auto    micros  =   std :: chrono :: duration_cast<std :: chrono :: microseconds>( Clock :: now() - sent ).count();
+
+                    samples[ c ].push_back( { route, static_cast<uint32_t>( micros ), status == 200 } );
+                }
+            }
+            catch( const std :: exception& e )
+            {
+                std :: cerr << "loadgen: connection " << c << ": " << e.what() << std :: endl;
+                failed = true;
+            }
+        } );
+    }
+
+    for( auto& client : clients )
+        client.join();
+
+    double seconds = std :: chrono :: duration<double>( Clock :: now() - start ).count();
+
+    server.stop();
+    done.wait();
+
+    std :: vector<uint32_t>                 all;
+    std :: vector<std :: vector<uint32_t>>  perRoute( routes.size() );
+    std :: vector<size_t>                   errors( routes.size() );
+    size_t                                  totalErrors = 0;
+
+    for( const auto& connection : samples )
+    {
+        for( const auto& sample : connection )
+        {
+            all.push_back( sample.micros );
+            perRoute[ sample.route ].push_back( sample.micros );
+            errors[ sample.route ]  += !sample.ok;
+            totalErrors             += !sample.ok;
+        }
+    }
+
+    std :: printf( "io threads %u, compute threads %u, connections %u, %.1f s\n\n",
+                   options.threads, options.compute, options.connections, seconds );
+    std :: printf( "%-12s %10s %8s %12s %10s %10s %10s\n", "route", "requests", "errors", "req/s", "p50 ms", "p99 ms", "p999 ms" );
+
+    for( size_t r = 0; r < routes.size(); r++ )
+        report( routes[ r ], std :: move( perRoute[ r ] ), errors[ r ], seconds );
+    report( "all", std :: move( all ), totalErrors, seconds );
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,321 @@
+/*!
+    make_synthetic_dataset: writes a concentration( time, z, y, x ) file with the same
+    layout as data/concentration.timeseries.nc at any size, for benchmarks and scale tests.
+
+    usage: make_synthetic_dataset --output FILE [--time N] [--z N] [--y N] [--x N]
+                                  [--format classic|64bit|netcdf4|netcdf4-classic]
+                                  [--chunk T,Z,Y,X] [--deflate 0-9] [--shuffle]
+                                  [--wind M/S] [--rate KG/S] [--release-time S] [--seed N]
+
+    The field is a ground-level continuous release: a Gaussian plume with Briggs rural
+    ( neutral ) dispersion, ground reflection in z, a front advancing at the wind speed
+    until the release stops, a slowly meandering wind direction and smooth multiplicative
+    turbulence. Values below 1e-12 kg/m3 are written as 0, so the grid is as sparse as
+    real model output. Chunking and deflate apply to the netCDF-4 formats only.
+*/
+
+#include "netcdf/netcdf.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct Options
+{
+    std :: string       output;
+    size_t              nt          =   8;
+    size_t              nz          =   1;
+    size_t              ny          =   27;
+    size_t              nx          =   36;
+    std :: string       format      =   "64bit";
+    std :: vector<size_t> chunk;
+    int                 deflate     =   0;
+    bool                shuffle     =   false;
+    double              wind        =   5.4;
+    double              rate        =   10.0;
+    double              releaseTime =   600.0;
+    unsigned            seed        =   1;
+};
+
+// abort with the library's message on any NetCDF error
+static void check( int status, const char* what )
+{
+    if( status != NC_NOERR )
+    {
+        std :: cerr << "make_synthetic_dataset: " << what << ": " << nc_strerror( status ) << std :: endl;
+        std :: exit( 1 );
+    }
+}
+
+static void usage()
+{
+    std :: cerr << "usage: make_synthetic_dataset --output FILE [--time N] [--z N] [--y N] [--x N]\n"
+                   "                              [--format classic|64bit|netcdf4|netcdf4-classic]\n"
+                   "                              [--chunk T,Z,Y,X] [--deflate 0-9] [--shuffle]\n"
+                   "                              [--wind M/S] [--rate KG/S] [--release-time S] [--seed N]" << std :: endl;
+    std :: exit( 1 );
+}
+
+static Options parseOptions( int argc, char** argv )
+{
+    Options options;
+
+    for( int i = 1; i < argc; i++ )
+    {
+        std :: string flag = argv[ i ];
+
+        if( flag == "--shuffle" )
+        {
+            options.shuffle = true;
+            continue;
+        }
+        if( i + 1 >= argc )
+            usage();
+
+        std :: string value = argv[ ++i ];
+
+        if( flag == "--output" )                options.output      = value;
+        else if( flag == "--time" )             options.nt          = std :: stoul( value );
+        else if( flag == "--z" )                options.nz          = std :: stoul( value );
+        else if( flag == "--y" )                options.ny          = std :: stoul( value );
+        else if( flag == "--x" )                options.nx          = std :: stoul( value );
+        else if( flag == "--format" )           options.format      = value;
+        else if( flag == "--deflate" )          options.deflate     = std :: stoi( value );
+        else if( flag == "--wind" )             options.wind        = std :: stod( value );
+        else if( flag == "--rate" )             options.rate        = std :: stod( value );
+        else if( flag == "--release-time" )     options.releaseTime = std :: stod( value );
+        else if( flag == "--seed" )             options.seed        = std :: stoul( value );
+        else if( flag == "--chunk" )
+        {
+            std :: stringstream list( value );
+            std :: string       item;
+            while( std :: getline( list, item, ',' ) )
+                options.chunk.push_back( std :: stoul( item ) );
+            if( options.chunk.size() != 4 )
+                usage();
+        }
+        else
+            usage();
+    }
+
+    if( options.output.empty() || !options.nt || !options.nz || !options.ny || !options.nx )
+        usage();
+
+    return options;
+}
+
+static int createMode( const std :: string& format )
+{
+    if( format == "classic" )           return NC_CLOBBER;
+    if( format == "64bit" )             return NC_CLOBBER | NC_64BIT_OFFSET;
+    if( format == "netcdf4" )           return NC_CLOBBER | NC_NETCDF4;
+    if( format == "netcdf4-classic" )   return NC_CLOBBER | NC_NETCDF4 | NC_CLASSIC_MODEL;
+    usage();
+    return 0;
+}
+
+/*!
+    Smooth 2D value noise on a coarse lattice, bilinearly interpolated, around 1.
+    Each time step relaxes the lattice towards a fresh random one, so eddies evolve 
+    instead of flickering between steps.
+*/
+class Turbulence
+{
+    public:
+        Turbulence( unsigned seed, size_t cells ) : random_( seed ), cells_( cells ), current_( lattice() )
+        {
+        }
+
+        void advance()
+        {
+            auto next = lattice();
+            for( size_t i = 0; i < current_.size(); i++ )
+                current_[ i ] = 0.7 * current_[ i ] + 0.3 * next[ i ];
+        }
+
+        // u, v in [ 0, 1 ] across the grid
+        double at( double u, double v ) const
+        {
+            return 1.0 + kAmplitude * sample( current_, u, v );
+        }
+
+    private:
+        static constexpr double kAmplitude = 0.35;
+
+        std :: mt19937          random_;
+        size_t                  cells_;
+        std :: vector<double>   current_;
+
+        std :: vector<double> lattice()
+        {
+            std :: uniform_real_distribution<double> uniform( -1.0, 1.0 );
+            std :: vector<double> values( ( cells_ + 1 ) * ( cells_ + 1 ) );
+            for( auto& value : values )
+                value = uniform( random_ );
+            return values;
+        }
+
+        double sample( const std :: vector<double>& lattice, double u, double v ) const
+        {
+            double  fu  =   u * cells_;
+            double  fv  =   v * cells_;
+            size_t  i   =   std :: min( cells_ - 1, static_cast<size_t>( fv ) );
+            size_t  j   =   std :: min( cells_ - 1, static_cast<size_t>( fu ) );
+            double  a   =   fv - i;
+            double  b   =   fu - j;
+            size_t  w   =   cells_ + 1;
+
+            return ( 1 - a ) * ( ( 1 - b ) * lattice[ i * w + j ] + b * lattice[ i * w + j + 1 ] ) +
+                   a * ( ( 1 - b ) * lattice[ ( i + 1 ) * w + j ] + b * lattice[ ( i + 1 ) * w + j + 1 ] );
+        }
+};
+
+int main( int argc, char** argv )
+{
+    Options options = parseOptions( argc, argv );
+
+    size_t nt = options.nt, nz = options.nz, ny = options.ny, nx = options.nx;
+
+    int ncid;
+    int timeDim, zDim, yDim, xDim;
+    int timeVar, zVar, yVar, xVar, concentrationVar;
+
+    bool netcdf4 = options.format.rfind( "netcdf4", 0 ) == 0;
+
+    check( nc_create( options.output.c_str(), createMode( options.format ), &ncid ), "nc_create" );
+
+    check( nc_def_dim( ncid, "time", nt, &timeDim ), "nc_def_dim time" );
+    check( nc_def_dim( ncid, "x", nx, &xDim ), "nc_def_dim x" );
+    check( nc_def_dim( ncid, "y", ny, &yDim ), "nc_def_dim y" );
+    check( nc_def_dim( ncid, "z", nz, &zDim ), "nc_def_dim z" );
+
+    int dims[ 4 ] = { timeDim, zDim, yDim, xDim };
+
+    check( nc_def_var( ncid, "time", NC_DOUBLE, 1, &timeDim, &timeVar ), "nc_def_var time" );
+    check( nc_def_var( ncid, "y", NC_DOUBLE, 1, &yDim, &yVar ), "nc_def_var y" );
+    check( nc_def_var( ncid, "x", NC_DOUBLE, 1, &xDim, &xVar ), "nc_def_var x" );
+    check( nc_def_var( ncid, "z", NC_DOUBLE, 1, &zDim, &zVar ), "nc_def_var z" );
+    check( nc_def_var( ncid, "concentration", NC_DOUBLE, 4, dims, &concentrationVar ), "nc_def_var concentration" );
+
+    if( netcdf4 )
+    {
+        // default to one ( y, x ) plane per chunk, the server's read pattern
+        std :: vector<size_t> chunk = options.chunk.empty() ? std :: vector<size_t>{ 1, 1, ny, nx } : options.chunk;
+        for( size_t d = 0; d < 4; d++ )
+            chunk[ d ] = std :: clamp<size_t>( chunk[ d ], 1, std :: vector<size_t>{ nt, nz, ny, nx }[ d ] );
+
+        check( nc_def_var_chunking( ncid, concentrationVar, NC_CHUNKED, chunk.data() ), "nc_def_var_chunking" );
+
+        if( options.deflate > 0 || options.shuffle )
+            check( nc_def_var_deflate( ncid, concentrationVar, options.shuffle, options.deflate > 0, options.deflate ), "nc_def_var_deflate" );
+    }
+    else if( !options.chunk.empty() || options.deflate > 0 || options.shuffle )
+    {
+        std :: cerr << "make_synthetic_dataset: --chunk, --deflate and --shuffle need a netcdf4 format, ignored" << std :: endl;
+    }
+
+    auto text = [ & ]( int var, const char* name, const std :: string& value )
+    {
+        check( nc_put_att_text( ncid, var, name, value.size(), value.c_str() ), name );
+    };
+
+    text( timeVar, "units", "seconds" );
+    text( timeVar, "long_name", "Seconds since release" );
+    text( yVar, "units", "m" );
+    text( yVar, "long_name", "y-coordinate distance from protection point (origin)" );
+    text( xVar, "units", "m" );
+    text( xVar, "long_name", "x-coordinate distance from protection point (origin)" );
+    text( zVar, "units", "m" );
+    text( zVar, "long_name", "z-coordinate distance from ground level" );
+    text( concentrationVar, "units", "kg/m3" );
+    text( concentrationVar, "long_name", "concentration of agent" );
+    text( NC_GLOBAL, "event_name", "SyntheticContinuousEvent" );
+    text( NC_GLOBAL, "mass_release_rate", std :: to_string( options.rate ) );
+    text( NC_GLOBAL, "total_release_time", std :: to_string( options.releaseTime ) );
+    text( NC_GLOBAL, "wind_speed", std :: to_string( options.wind ) );
+
+    check( nc_enddef( ncid ), "nc_enddef" );
+
+    // domain of the sample file, 10 km downwind by ~5 km crosswind, ~880 s steps
+    std :: vector<double> time( nt ), z( nz ), y( ny ), x( nx );
+    for( size_t i = 0; i < nt; i++ ) time[ i ] = 0.87890625 + 878.90625 * i;
+    for( size_t i = 0; i < nz; i++ ) z[ i ] = 2.0 + 10.0 * i;
+    for( size_t i = 0; i < ny; i++ ) y[ i ] = -2444.5 + 4889.0 * i / std :: max<size_t>( 1, ny - 1 );
+    for( size_t i = 0; i < nx; i++ ) x[ i ] = 10000.0 * i / std :: max<size_t>( 1, nx - 1 );
+
+    check( nc_put_var_double( ncid, timeVar, time.data() ), "put time" );
+    check( nc_put_var_double( ncid, zVar, z.data() ), "put z" );
+    check( nc_put_var_double( ncid, yVar, y.data() ), "put y" );
+    check( nc_put_var_double( ncid, xVar, x.data() ), "put x" );
+
+    Turbulence              turbulence( options.seed, 12 );
+    std :: mt19937          random( options.seed );
+    std :: normal_distribution<double> meander( 0.0, 0.04 );
+    double                  direction = 0.0;
+
+    // one plane in memory, rows computed in parallel
+    std :: vector<double> plane( ny * nx );
+
+    for( size_t t = 0; t < nt; t++ )
+    {
+        // wind direction random walk ( radians ), turbulence lattice evolves every step
+        direction = std :: clamp( direction + meander( random ), -0.35, 0.35 );
+        turbulence.advance();
+
+        double cosd     =   std :: cos( direction );
+        double sind     =   std :: sin( direction );
+        double front    =   options.wind * time[ t ];
+        double tail     =   options.wind * std :: max( 0.0, time[ t ] - options.releaseTime );
+
+        for( size_t k = 0; k < nz; k++ )
+        {
+            parallelFor( ny, [ & ]( size_t i )
+            {
+                for( size_t j = 0; j < nx; j++ )
+                {
+                    // plume frame: downwind distance d, crosswind c
+                    double d = x[ j ] * cosd + y[ i ] * sind;
+                    double c = -x[ j ] * sind + y[ i ] * cosd;
+
+                    double value = 0.0;
+                    if( d > 1.0 )
+                    {
+                        // Briggs rural, neutral stability ( class D )
+                        double sy = 0.08 * d / std :: sqrt( 1.0 + 0.0001 * d );
+                        double sz = 0.06 * d / std :: sqrt( 1.0 + 0.0015 * d );
+
+                        // leading edge, and trailing edge once the release has stopped, smeared over ~ one sigma
+                        double leading  = 0.5 * std :: erfc( ( d - front ) / ( M_SQRT2 * sy ) );
+                        double trailing = tail > 0.0 ? 0.5 * std :: erfc( ( tail - d ) / ( M_SQRT2 * sy ) ) : 1.0;
+                        double edges    = leading * trailing;
+
+                        // ground release, reflected at z = 0
+                        value = options.rate / ( M_PI * options.wind * sy * sz ) *
+                                std :: exp( -0.5 * c * c / ( sy * sy ) ) *
+                                std :: exp( -0.5 * z[ k ] * z[ k ] / ( sz * sz ) ) *
+                                edges *
+                                turbulence.at( double( j ) / nx, double( i ) / ny );
+                    }
+
+                    plane[ i * nx + j ] = value < 1e-12 ? 0.0 : value;
+                }
+            } );
+
+            size_t start[ 4 ] = { t, k, 0, 0 };
+            size_t count[ 4 ] = { 1, 1, ny, nx };
+            check( nc_put_vara_double( ncid, concentrationVar, start, count, plane.data() ), "put concentration" );
+        }
+
+        std :: cerr << "\rmake_synthetic_dataset: time step " << t + 1 << " / " << nt << std :: flush;
+    }
+    std :: cerr << std :: endl;
+
+    check( nc_close( ncid ), "nc_close" );
+    return 0;
+}